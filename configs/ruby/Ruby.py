@@ -69,6 +69,8 @@ def define_options(parser):
                       choices=['fixed', 'flexible'], help="'fixed'|'flexible'")
     parser.add_option("--network-fault-model", action="store_true", default=False,
                       help="enable network fault model: see src/mem/ruby/network/fault_model/")
+    parser.add_option("--event-driven-throttle", action="store_true", default=False,
+                      help="simple network: throttles sleep while a message holds the link")
 
     # ruby mapping options
     parser.add_option("--numa-high-bit", type="int", default=0,
@@ -108,6 +110,36 @@ def define_options(parser):
                        help="TOPAZ: Number of messages that has to be transmitted "\
                              "before to activate TOPAZ" )
 
+    parser.add_option("--topaz-hybrid-low-watermark", type="int", default=0,
+                       help="TOPAZ: in-flight messages below which traffic "\
+                             "returns to the Ruby network")
+
+    parser.add_option("--topaz-hybrid-high-watermark", type="int", default=0,
+                       help="TOPAZ: in-flight messages at which traffic "\
+                             "moves to TOPAZ")
+
+    parser.add_option("--topaz-hybrid-min-dwell", type="int", default=1000,
+                       help="TOPAZ: minimum cycles between two network switches")
+
+    parser.add_option("--topaz-worker-threads", type="int", default=0,
+                       help="TOPAZ: host threads advancing the per-vnet "\
+                             "simulations in parallel (0 or 1 disables)")
+    parser.add_option("--topaz-vnets", type="string", default="",
+                       help="TOPAZ: comma separated vnets modeled by TOPAZ, "\
+                             "the others use the Ruby switches (default all)")
+    parser.add_option("--topaz-sampling", action="store_true", default=False,
+                       help="TOPAZ: alternate detailed windows with windows "\
+                             "using latencies learned in the detailed ones")
+    parser.add_option("--topaz-sample-detailed-window", type="int",
+                       default=10000,
+                       help="TOPAZ: cycles simulated in detail per period")
+    parser.add_option("--topaz-sample-fast-window", type="int", default=90000,
+                       help="TOPAZ: cycles using drawn latencies per period")
+    parser.add_option("--topaz-sample-load-buckets", type="int", default=4,
+                       help="TOPAZ: load levels of the latency distributions")
+    parser.add_option("--topaz-sample-confidence", type="float", default=0.95,
+                       help="TOPAZ: confidence level of the latency interval")
+
 
     protocol = buildEnv['PROTOCOL']
     exec "import %s" % protocol
@@ -193,6 +225,10 @@ def create_system(options, system, piobus = None, dma_ports = []):
         network.enable_fault_model = True
         network.fault_model = FaultModel()
 
+    if options.event_driven_throttle:
+        assert(NetworkClass == SimpleNetwork)
+        network.event_driven_throttle = True
+
     #
     #  TOPAZ INPUT PARAMETERS
     #
@@ -203,6 +239,18 @@ def create_system(options, system, piobus = None, dma_ports = []):
        network.topaz_flit_size =  options.topaz_flit_size
        network.topaz_clock_ratio = options.topaz_clock_ratio
        network.topaz_adaptive_interface_threshold = options.topaz_adaptive_interface_threshold
+       network.topaz_hybrid_low_watermark = options.topaz_hybrid_low_watermark
+       network.topaz_hybrid_high_watermark = options.topaz_hybrid_high_watermark
+       network.topaz_hybrid_min_dwell = options.topaz_hybrid_min_dwell
+       network.topaz_worker_threads = options.topaz_worker_threads
+       if options.topaz_vnets:
+           network.topaz_vnets = [int(v) for v in options.topaz_vnets.split(",")]
+       network.topaz_sampling = options.topaz_sampling
+       network.topaz_sample_detailed_window = \
+           options.topaz_sample_detailed_window
+       network.topaz_sample_fast_window = options.topaz_sample_fast_window
+       network.topaz_sample_load_buckets = options.topaz_sample_load_buckets
+       network.topaz_sample_confidence = options.topaz_sample_confidence
        network.topaz_init_file = options.topaz_init_file
 
     #
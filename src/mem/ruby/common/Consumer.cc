@@ -30,6 +30,32 @@
 
 using namespace std;
 
+Consumer::Consumer(ClockedObject *_em)
+    : em(_em)
+{
+    for (int i = 0; i < WAKEUP_SLOTS; i++)
+        m_wakeup_slots[i] = new ConsumerEvent(this);
+}
+
+Consumer::~Consumer()
+{
+    for (int i = 0; i < WAKEUP_SLOTS; i++) {
+        if (m_wakeup_slots[i]->scheduled())
+            em->deschedule(m_wakeup_slots[i]);
+        delete m_wakeup_slots[i];
+    }
+}
+
+bool
+Consumer::alreadyScheduled(Tick time)
+{
+    ConsumerEvent &slot = wakeupSlot(time);
+    if (slot.scheduled() && slot.when() == time)
+        return true;
+    return !m_scheduled_wakeups.empty() &&
+        m_scheduled_wakeups.find(time) != m_scheduled_wakeups.end();
+}
+
 void
 Consumer::scheduleEvent(Cycles timeDelta)
 {
@@ -39,15 +65,22 @@ Consumer::scheduleEvent(Cycles timeDelta)
 void
 Consumer::scheduleEventAbsolute(Tick evt_time)
 {
-    if (!alreadyScheduled(evt_time)) {
-        // This wakeup is not redundant
-        ConsumerEvent *evt = new ConsumerEvent(this);
-        em->schedule(evt, evt_time);
-        insertScheduledWakeupTime(evt_time);
+    if (alreadyScheduled(evt_time))
+        return;
+
+    // This wakeup is not redundant
+    ConsumerEvent &slot = wakeupSlot(evt_time);
+    if (!slot.scheduled()) {
+        em->schedule(&slot, evt_time);
+        return;
     }
 
+    // the slot holds a wakeup WAKEUP_SLOTS cycles away from this one
+    ConsumerEvent *evt = new ConsumerEvent(this, true);
+    em->schedule(evt, evt_time);
+
     Tick t = em->clockEdge();
-    set<Tick>::iterator bit = m_scheduled_wakeups.begin();
-    set<Tick>::iterator eit = m_scheduled_wakeups.lower_bound(t);
-    m_scheduled_wakeups.erase(bit,eit);
+    m_scheduled_wakeups.erase(m_scheduled_wakeups.begin(),
+                              m_scheduled_wakeups.lower_bound(t));
+    m_scheduled_wakeups.insert(evt_time);
 }
@@ -29,7 +29,7 @@
 /*
  * This is the virtual base class of all classes that can be the
  * targets of wakeup events.  There is only two methods, wakeup() and
- * print() and no data members.
+ * print(), and the bookkeeping needed to avoid redundant wakeups.
  */
 
 #ifndef __MEM_RUBY_COMMON_CONSUMER_HH__
@@ -43,30 +43,15 @@
 class Consumer
 {
   public:
-    Consumer(ClockedObject *_em)
-        : em(_em)
-    {
-    }
+    Consumer(ClockedObject *_em);
 
-    virtual
-    ~Consumer()
-    { }
+    virtual ~Consumer();
 
     virtual void wakeup() = 0;
     virtual void print(std::ostream& out) const = 0;
     virtual void storeEventInfo(int info) {}
 
-    bool
-    alreadyScheduled(Tick time)
-    {
-        return m_scheduled_wakeups.find(time) != m_scheduled_wakeups.end();
-    }
-
-    void
-    insertScheduledWakeupTime(Tick time)
-    {
-        m_scheduled_wakeups.insert(time);
-    }
+    bool alreadyScheduled(Tick time);
 
     void scheduleEventAbsolute(Tick timeAbs);
 
@@ -74,14 +59,16 @@ class Consumer
     void scheduleEvent(Cycles timeDelta);
 
   private:
-    std::set<Tick> m_scheduled_wakeups;
-    ClockedObject *em;
+    // the wakeup events belong to this consumer, it cannot be copied
+    Consumer(const Consumer& obj);
+    Consumer& operator=(const Consumer& obj);
 
     class ConsumerEvent : public Event
     {
       public:
-          ConsumerEvent(Consumer* _consumer)
-              : Event(Default_Pri, AutoDelete), m_consumer_ptr(_consumer)
+          ConsumerEvent(Consumer* _consumer, bool auto_delete = false)
+              : Event(Default_Pri, auto_delete ? AutoDelete : 0),
+                m_consumer_ptr(_consumer)
           {
           }
 
@@ -90,6 +77,23 @@ class Consumer
       private:
           Consumer* m_consumer_ptr;
     };
+
+    //! Wakeups within the next WAKEUP_SLOTS cycles use the event of the
+    //! slot of their cycle, which is pending exactly when that wakeup is.
+    //! This filters redundant wakeups without a search or an allocation.
+    static const int WAKEUP_SLOTS = 16;
+
+    ConsumerEvent &
+    wakeupSlot(Tick time)
+    {
+        return *m_wakeup_slots[(time / em->clockPeriod()) %
+                               WAKEUP_SLOTS];
+    }
+
+    ClockedObject *em;
+    ConsumerEvent *m_wakeup_slots[WAKEUP_SLOTS];
+    //! wakeups whose slot was already taken, each with its own event
+    std::set<Tick> m_scheduled_wakeups;
 };
 
 inline std::ostream&
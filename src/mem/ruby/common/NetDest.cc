@@ -45,8 +45,8 @@ NetDest::add(MachineID newElement)
 void
 NetDest::addNetDest(const NetDest& netDest)
 {
-    assert(m_bits.size() == netDest.getSize());
-    for (int i = 0; i < m_bits.size(); i++) {
+    assert(getSize() == netDest.getSize());
+    for (int i = 0; i < MachineType_NUM; i++) {
         m_bits[i].addSet(netDest.m_bits[i]);
     }
 }
@@ -69,8 +69,8 @@ NetDest::remove(MachineID oldElement)
 void
 NetDest::removeNetDest(const NetDest& netDest)
 {
-    assert(m_bits.size() == netDest.getSize());
-    for (int i = 0; i < m_bits.size(); i++) {
+    assert(getSize() == netDest.getSize());
+    for (int i = 0; i < MachineType_NUM; i++) {
         m_bits[i].removeSet(netDest.m_bits[i]);
     }
 }
@@ -78,7 +78,7 @@ NetDest::removeNetDest(const NetDest& netDest)
 void
 NetDest::clear()
 {
-    for (int i = 0; i < m_bits.size(); i++) {
+    for (int i = 0; i < MachineType_NUM; i++) {
         m_bits[i].clear();
     }
 }
@@ -106,23 +106,29 @@ std::vector<NodeID>
 NetDest::getAllDest()
 {
     std::vector<NodeID> dest;
-    dest.clear();
-    for (int i = 0; i < m_bits.size(); i++) {
-        for (int j = 0; j < m_bits[i].getSize(); j++) {
-            if (m_bits[i].isElement(j)) {
-                int id = MachineType_base_number((MachineType)i) + j;
-                dest.push_back((NodeID)id);
-            }
+    getAllDest(dest);
+    return dest;
+}
+
+// Appends the node number of every element, visiting only the set bits
+void
+NetDest::getAllDest(std::vector<NodeID>& dest) const
+{
+    for (int i = 0; i < MachineType_NUM; i++) {
+        const Set& bits = m_bits[i];
+        int base = MachineType_base_number((MachineType)i);
+        for (NodeID j = bits.nextElement(0); j < bits.getSize();
+             j = bits.nextElement(j + 1)) {
+            dest.push_back((NodeID)(base + j));
         }
     }
-    return dest;
 }
 
 int
 NetDest::count() const
 {
     int counter = 0;
-    for (int i = 0; i < m_bits.size(); i++) {
+    for (int i = 0; i < MachineType_NUM; i++) {
         counter += m_bits[i].count();
     }
     return counter;
@@ -138,7 +144,7 @@ MachineID
 NetDest::smallestElement() const
 {
     assert(count() > 0);
-    for (int i = 0; i < m_bits.size(); i++) {
+    for (int i = 0; i < MachineType_NUM; i++) {
         for (NodeID j = 0; j < m_bits[i].getSize(); j++) {
             if (m_bits[i].isElement(j)) {
                 MachineID mach = {MachineType_from_base_level(i), j};
@@ -167,7 +173,7 @@ NetDest::smallestElement(MachineType machine) const
 bool
 NetDest::isBroadcast() const
 {
-    for (int i = 0; i < m_bits.size(); i++) {
+    for (int i = 0; i < MachineType_NUM; i++) {
         if (!m_bits[i].isBroadcast()) {
             return false;
         }
@@ -179,7 +185,7 @@ NetDest::isBroadcast() const
 bool
 NetDest::isEmpty() const
 {
-    for (int i = 0; i < m_bits.size(); i++) {
+    for (int i = 0; i < MachineType_NUM; i++) {
         if (!m_bits[i].isEmpty()) {
             return false;
         }
@@ -191,11 +197,9 @@ NetDest::isEmpty() const
 NetDest
 NetDest::OR(const NetDest& orNetDest) const
 {
-    assert(m_bits.size() == orNetDest.getSize());
-    NetDest result;
-    for (int i = 0; i < m_bits.size(); i++) {
-        result.m_bits[i] = m_bits[i].OR(orNetDest.m_bits[i]);
-    }
+    assert(getSize() == orNetDest.getSize());
+    NetDest result(*this);
+    result.addNetDest(orNetDest);
     return result;
 }
 
@@ -203,9 +207,9 @@ NetDest::OR(const NetDest& orNetDest) const
 NetDest
 NetDest::AND(const NetDest& andNetDest) const
 {
-    assert(m_bits.size() == andNetDest.getSize());
-    NetDest result;
-    for (int i = 0; i < m_bits.size(); i++) {
+    assert(getSize() == andNetDest.getSize());
+    NetDest result(*this);
+    for (int i = 0; i < MachineType_NUM; i++) {
         result.m_bits[i] = m_bits[i].AND(andNetDest.m_bits[i]);
     }
     return result;
@@ -215,21 +219,22 @@ NetDest::AND(const NetDest& andNetDest) const
 bool
 NetDest::intersectionIsNotEmpty(const NetDest& other_netDest) const
 {
-    assert(m_bits.size() == other_netDest.getSize());
-    for (int i = 0; i < m_bits.size(); i++) {
-        if (!m_bits[i].intersectionIsEmpty(other_netDest.m_bits[i])) {
-            return true;
-        }
+    assert(getSize() == other_netDest.getSize());
+    // no early exit, the loop is short and branch free
+    bool intersect = false;
+    for (int i = 0; i < MachineType_NUM; i++) {
+        intersect |=
+            !m_bits[i].intersectionIsEmpty(other_netDest.m_bits[i]);
     }
-    return false;
+    return intersect;
 }
 
 bool
 NetDest::isSuperset(const NetDest& test) const
 {
-    assert(m_bits.size() == test.getSize());
+    assert(getSize() == test.getSize());
 
-    for (int i = 0; i < m_bits.size(); i++) {
+    for (int i = 0; i < MachineType_NUM; i++) {
         if (!m_bits[i].isSuperset(test.m_bits[i])) {
             return false;
         }
@@ -246,10 +251,9 @@ NetDest::isElement(MachineID element) const
 void
 NetDest::resize()
 {
-    m_bits.resize(MachineType_base_level(MachineType_NUM));
-    assert(m_bits.size() == MachineType_NUM);
+    assert(MachineType_base_level(MachineType_NUM) == MachineType_NUM);
 
-    for (int i = 0; i < m_bits.size(); i++) {
+    for (int i = 0; i < MachineType_NUM; i++) {
         m_bits[i].setSize(MachineType_base_count((MachineType)i));
     }
 }
@@ -257,9 +261,9 @@ NetDest::resize()
 void
 NetDest::print(std::ostream& out) const
 {
-    out << "[NetDest (" << m_bits.size() << ") ";
+    out << "[NetDest (" << MachineType_NUM << ") ";
 
-    for (int i = 0; i < m_bits.size(); i++) {
+    for (int i = 0; i < MachineType_NUM; i++) {
         for (int j = 0; j < m_bits[i].getSize(); j++) {
             out << (bool) m_bits[i].isElement(j) << " ";
         }
@@ -271,8 +275,8 @@ NetDest::print(std::ostream& out) const
 bool
 NetDest::isEqual(const NetDest& n) const
 {
-    assert(m_bits.size() == n.m_bits.size());
-    for (unsigned int i = 0; i < m_bits.size(); ++i) {
+    assert(getSize() == n.getSize());
+    for (unsigned int i = 0; i < MachineType_NUM; ++i) {
         if (!m_bits[i].isEqual(n.m_bits[i]))
             return false;
     }
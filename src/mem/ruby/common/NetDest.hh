@@ -84,12 +84,13 @@ class NetDest
 
     // For Princeton Network
     std::vector<NodeID> getAllDest();
+    void getAllDest(std::vector<NodeID>& dest) const;
 
     MachineID smallestElement() const;
     MachineID smallestElement(MachineType machine) const;
 
     void resize();
-    int getSize() const { return m_bits.size(); }
+    int getSize() const { return MachineType_NUM; }
 
     // get element for a index
     NodeID elementAt(MachineID index);
@@ -103,13 +104,15 @@ class NetDest
     vecIndex(MachineID m) const
     {
         int vec_index = MachineType_base_level(m.type);
-        assert(vec_index < m_bits.size());
+        assert(vec_index < MachineType_NUM);
         return vec_index;
     }
 
     NodeID bitIndex(NodeID index) const { return index; }
 
-    std::vector<Set> m_bits;  // a vector of bit vectors - i.e. Sets
+    // a bit vector - i.e. Set - per machine type, held in the object so
+    // that copying and combining NetDests never allocates
+    Set m_bits[MachineType_NUM];
 };
 
 inline std::ostream&
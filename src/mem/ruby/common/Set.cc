@@ -32,63 +32,81 @@
 #include <cassert>
 #include <cstdio>
 
+#include "base/bitfield.hh"
 #include "base/misc.hh"
 #include "mem/ruby/common/Set.hh"
 
 Set::Set()
+    : m_nArrayLen(0), m_p_nArray(m_p_nArray_Static)
 {
-    m_p_nArray = NULL;
-    m_nArrayLen = 0;
-    m_nSize = 0;
+    setSize(0);
 }
 
-Set::Set(const Set& obj)
+Set::Set(int size)
+    : m_nArrayLen(0), m_p_nArray(m_p_nArray_Static)
 {
-    m_p_nArray = NULL;
-    setSize(obj.m_nSize);
-
-    // copy from the host to this array
-    for (int i = 0; i < m_nArrayLen; i++)
-        m_p_nArray[i] = obj.m_p_nArray[i];
+    setSize(size);
 }
 
-Set::Set(int size)
+Set::Set(const Set& obj)
+    : m_nArrayLen(0), m_p_nArray(m_p_nArray_Static)
 {
-    m_p_nArray = NULL;
-    m_nArrayLen = 0;
-    m_nSize = 0;
-    if (size > 0)
-        setSize(size);
+    *this = obj;
 }
 
 Set::~Set()
 {
-    if (m_p_nArray && m_p_nArray != &m_p_nArray_Static[0])
+    if (m_p_nArray != m_p_nArray_Static)
         delete [] m_p_nArray;
-    m_p_nArray = NULL;
 }
 
-void
-Set::clearExcess()
+Set&
+Set::operator=(const Set& obj)
 {
-    // now just ensure that no bits over the maximum size were set
-#ifdef _LP64
-    long mask = 0x7FFFFFFFFFFFFFFF;
-#else
-    long mask = 0x7FFFFFFF;
-#endif
+    if (this == &obj)
+        return *this;
+    allocate((obj.m_nSize + LONG_BITS - 1) / LONG_BITS);
+    m_nSize = obj.m_nSize;
+    if (m_p_nArray == m_p_nArray_Static) {
+        // a fixed number of words, so the copy is unrolled
+        for (int i = 0; i < NUMBER_WORDS_PER_SET; i++)
+            m_p_nArray[i] = obj.m_p_nArray_Static[i];
+    } else {
+        for (int i = 0; i < m_nArrayLen; i++)
+            m_p_nArray[i] = obj.m_p_nArray[i];
+    }
+    return *this;
+}
 
-    // the number of populated spaces in the higest-order array slot
-    // is: m_nSize % LONG_BITS, so the uppermost LONG_BITS -
-    // m_nSize%64 bits should be cleared
-    if ((m_nSize % LONG_BITS) != 0) {
-        for (int j = 0; j < 64 - (m_nSize & INDEX_MASK); j++) {
-            m_p_nArray[m_nArrayLen - 1] &= mask;
-            mask = mask >> 1;
-        }
+/*
+ * Points m_p_nArray at room for the given number of words: the array in
+ * the object when they fit in it, otherwise a heap array, kept when it
+ * already has that length. The contents are left undefined.
+ */
+void
+Set::allocate(int words)
+{
+    if (words <= NUMBER_WORDS_PER_SET) {
+        if (m_p_nArray != m_p_nArray_Static)
+            delete [] m_p_nArray;
+        m_p_nArray = m_p_nArray_Static;
+    } else if (m_p_nArray == m_p_nArray_Static || words != m_nArrayLen) {
+        if (m_p_nArray != m_p_nArray_Static)
+            delete [] m_p_nArray;
+        m_p_nArray = new unsigned long[words];
     }
+    m_nArrayLen = words;
 }
 
+void
+Set::clearExcess()
+{
+    // clear the bits beyond m_nSize in the last word in use
+    if ((m_nSize & INDEX_MASK) != 0) {
+        m_p_nArray[m_nArrayLen - 1] &=
+            (((unsigned long)1) << (m_nSize & INDEX_MASK)) - 1;
+    }
+}
 
 /*
  * This function should set all the bits in the current set that are
@@ -120,8 +138,7 @@ void
 Set::broadcast()
 {
     for (int i = 0; i < m_nArrayLen; i++)
-        m_p_nArray[i] = -1; // note that -1 corresponds to all 1's in 2's comp.
-
+        m_p_nArray[i] = ~((unsigned long)0);
     clearExcess();
 }
 
@@ -132,21 +149,8 @@ int
 Set::count() const
 {
     int counter = 0;
-    long mask;
-
-    for (int i = 0; i < m_nArrayLen; i++) {
-        mask = (long)0x01;
-
-        for (int j = 0; j < LONG_BITS; j++) {
-            // FIXME - significant performance loss when array
-            // population << LONG_BITS
-            if ((m_p_nArray[i] & mask) != 0) {
-                counter++;
-            }
-            mask = mask << 1;
-        }
-    }
-
+    for (int i = 0; i < m_nArrayLen; i++)
+        counter += popCount(m_p_nArray[i]);
     return counter;
 }
 
@@ -157,12 +161,10 @@ bool
 Set::isEqual(const Set& set) const
 {
     assert(m_nSize == set.m_nSize);
-
+    unsigned long differ = 0;
     for (int i = 0; i < m_nArrayLen; i++)
-        if (m_p_nArray[i] != set.m_p_nArray[i])
-            return false;
-
-    return true;
+        differ |= m_p_nArray[i] ^ set.m_p_nArray[i];
+    return differ == 0;
 }
 
 /*
@@ -172,55 +174,43 @@ NodeID
 Set::smallestElement() const
 {
     assert(count() > 0);
-    long x;
     for (int i = 0; i < m_nArrayLen; i++) {
-        if (m_p_nArray[i] != 0) {
-            // the least-set bit must be in here
-            x = m_p_nArray[i];
-
-            for (int j = 0; j < LONG_BITS; j++) {
-                if (x & (unsigned long)1) {
-                    return LONG_BITS * i + j;
-                }
-
-                x = x >> 1;
-            }
-
-            panic("No smallest element of an empty set.");
-        }
+        if (m_p_nArray[i] != 0)
+            return LONG_BITS * i + findLsbSet(m_p_nArray[i]);
     }
-
     panic("No smallest element of an empty set.");
 }
 
+/*
+ * This function returns the smallest element >= index, or getSize()
+ * if there is none. Only the words holding set bits are examined, so
+ * walking a sparse set costs one step per element.
+ */
+NodeID
+Set::nextElement(NodeID index) const
+{
+    int i = index >> INDEX_SHIFT;
+    if (index >= m_nSize)
+        return m_nSize;
+    unsigned long x = m_p_nArray[i] &
+                      (~((unsigned long)0) << (index & INDEX_MASK));
+    while (x == 0) {
+        if (++i >= m_nArrayLen)
+            return m_nSize;
+        x = m_p_nArray[i];
+    }
+    return LONG_BITS * i + findLsbSet(x);
+}
+
 /*
  * this function returns true iff all bits are set
  */
 bool
 Set::isBroadcast() const
 {
-    // check the fully-loaded words by equal to 0xffffffff
-    // only the last word may not be fully loaded, it is not
-    // fully loaded iff m_nSize % 32 or 64 !=0 => fully loaded iff
-    // m_nSize % 32 or 64 == 0
-
-    int max = (m_nSize % LONG_BITS) == 0 ? m_nArrayLen : m_nArrayLen - 1;
-    for (int i = 0; i < max; i++) {
-        if (m_p_nArray[i] != -1) {
-            return false;
-        }
-    }
-
-    // now check the last word, which may not be fully loaded
-    long mask = 1;
-    for (int j = 0; j < (m_nSize % LONG_BITS); j++) {
-        if ((mask & m_p_nArray[m_nArrayLen-1]) == 0) {
-            return false;
-        }
-        mask = mask << 1;
-    }
-
-    return true;
+    Set all(m_nSize);
+    all.broadcast();
+    return isEqual(all);
 }
 
 /*
@@ -231,22 +221,18 @@ Set::isEmpty() const
 {
     // here we can simply check if all = 0, since we ensure
     // that "extra slots" are all zero
-    for (int i = 0; i < m_nArrayLen ; i++)
-        if (m_p_nArray[i])
-            return false;
-
-    return true;
+    unsigned long any = 0;
+    for (int i = 0; i < m_nArrayLen; i++)
+        any |= m_p_nArray[i];
+    return any == 0;
 }
 
 // returns the logical OR of "this" set and orSet
 Set
 Set::OR(const Set& orSet) const
 {
-    Set result(m_nSize);
-    assert(m_nSize == orSet.m_nSize);
-    for (int i = 0; i < m_nArrayLen; i++)
-        result.m_p_nArray[i] = m_p_nArray[i] | orSet.m_p_nArray[i];
-
+    Set result(*this);
+    result.addSet(orSet);
     return result;
 }
 
@@ -254,13 +240,10 @@ Set::OR(const Set& orSet) const
 Set
 Set::AND(const Set& andSet) const
 {
-    Set result(m_nSize);
+    Set result(*this);
     assert(m_nSize == andSet.m_nSize);
-
-    for (int i = 0; i < m_nArrayLen; i++) {
-        result.m_p_nArray[i] = m_p_nArray[i] & andSet.m_p_nArray[i];
-    }
-
+    for (int i = 0; i < m_nArrayLen; i++)
+        result.m_p_nArray[i] &= andSet.m_p_nArray[i];
     return result;
 }
 
@@ -272,69 +255,34 @@ bool
 Set::isSuperset(const Set& test) const
 {
     assert(m_nSize == test.m_nSize);
-
+    unsigned long missing = 0;
     for (int i = 0; i < m_nArrayLen; i++)
-        if (((test.m_p_nArray[i] & m_p_nArray[i]) | ~test.m_p_nArray[i]) != -1)
-            return false;
-
-    return true;
+        missing |= test.m_p_nArray[i] & ~m_p_nArray[i];
+    return missing == 0;
 }
 
 void
 Set::setSize(int size)
 {
+    allocate((size + LONG_BITS - 1) / LONG_BITS);
     m_nSize = size;
-    m_nArrayLen = (m_nSize + LONG_BITS - 1) / LONG_BITS;
-
-    // decide whether to use dynamic or static alloction
-    if (m_nArrayLen <= NUMBER_WORDS_PER_SET) {
-        // constant defined in RubySystem.hh
-        // its OK to use the static allocation, and it will
-        // probably be faster (as m_nArrayLen is already in the
-        // cache and they will probably share the same cache line)
-
-        // if switching from dyanamic to static allocation (which
-        // is probably rare, but why not be complete?), must delete
-        // the dynamically allocated space
-        if (m_p_nArray && m_p_nArray != &m_p_nArray_Static[0])
-            delete [] m_p_nArray;
-
-        m_p_nArray = &m_p_nArray_Static[0];
+    if (m_p_nArray == m_p_nArray_Static) {
+        // the words past the new size must be zero too
+        for (int i = 0; i < NUMBER_WORDS_PER_SET; i++)
+            m_p_nArray[i] = 0;
     } else {
-        // can't use static allocation...simply not enough room
-        // so dynamically allocate some space
-        if (m_p_nArray && m_p_nArray != &m_p_nArray_Static[0])
-            delete [] m_p_nArray;
-
-        m_p_nArray = new long[m_nArrayLen];
-    }
-
-    clear();
-}
-
-Set&
-Set::operator=(const Set& obj)
-{
-    if (this != &obj) {
-        // resize this item
-        setSize(obj.getSize());
-
-        // copy the elements from obj to this
         for (int i = 0; i < m_nArrayLen; i++)
-            m_p_nArray[i] = obj.m_p_nArray[i];
+            m_p_nArray[i] = 0;
     }
-
-    return *this;
 }
 
 void
 Set::print(std::ostream& out) const
 {
-    if (!m_p_nArray) {
+    if (m_nSize == 0) {
         out << "[Set {Empty}]";
         return;
     }
-
     out << "[Set (" << m_nSize << ")";
     for (int i = m_nArrayLen - 1; i >= 0; i--) {
         out << csprintf(" 0x%08X", m_p_nArray[i]);
@@ -35,41 +35,35 @@
 #include <iostream>
 #include <limits>
 
+#include "config/number_bits_per_set.hh"
 #include "mem/ruby/common/TypeDefines.hh"
 
 /*
- * This defines the number of longs (32-bits on 32 bit machines,
- * 64-bit on 64-bit AMD machines) to use to hold the set...
- * the default is 4, allowing 128 or 256 different members
- * of the set.
- *
- * This should never need to be changed for correctness reasons,
- * though increasing it will increase performance for larger
- * set sizes at the cost of a (much) larger memory footprint
- *
+ * Sets of up to NUMBER_BITS_PER_SET nodes, a build option (scons
+ * NUMBER_BITS_PER_SET=...), keep their bits in the object itself, so
+ * they are copied and combined without allocating. Larger sets still
+ * work, with their words on the heap. The operations are branch free
+ * loops over the words in use, which the compiler vectorizes. Bits
+ * beyond the size of the set are always zero.
  */
-const int NUMBER_WORDS_PER_SET = 1;
 
 class Set
 {
   private:
-    int m_nSize;              // the number of bits in this set
-    int m_nArrayLen;          // the number of 32-bit words that are
-                              // held in the array
-
-    // Changed 5/24/05 for static allocation of array
-    // note that "long" corresponds to 32 bits on a 32-bit machine,
-    // 64 bits if the -m64 parameter is passed to g++, which it is
-    // for an AMD opteron under our configuration
-
-    long *m_p_nArray;      // an word array to hold the bits in the set
-    long m_p_nArray_Static[NUMBER_WORDS_PER_SET];
-
-    static const int LONG_BITS = std::numeric_limits<long>::digits + 1;
+    static const int LONG_BITS = std::numeric_limits<unsigned long>::digits;
     static const int INDEX_SHIFT = LONG_BITS == 64 ? 6 : 5;
     static const int INDEX_MASK = (1 << INDEX_SHIFT) - 1;
+    static const int NUMBER_WORDS_PER_SET =
+        (NUMBER_BITS_PER_SET + LONG_BITS - 1) / LONG_BITS;
+
+    int m_nSize;              // the number of bits in this set
+    int m_nArrayLen;          // the number of words holding them
+    // m_p_nArray_Static, or a heap array for sets that do not fit in it
+    unsigned long *m_p_nArray;
+    unsigned long m_p_nArray_Static[NUMBER_WORDS_PER_SET];
 
     void clearExcess();
+    void allocate(int words);
 
   public:
     Set();
@@ -118,10 +112,10 @@ class Set
     bool
     intersectionIsEmpty(const Set& other_set) const
     {
+        unsigned long common = 0;
         for (int i = 0; i < m_nArrayLen; i++)
-            if (m_p_nArray[i] & other_set.m_p_nArray[i])
-                return false;
-        return true;
+            common |= m_p_nArray[i] & other_set.m_p_nArray[i];
+        return common == 0;
     }
 
     bool isSuperset(const Set& test) const;
@@ -138,6 +132,7 @@ class Set
     bool isEmpty() const;
 
     NodeID smallestElement() const;
+    NodeID nextElement(NodeID index) const;
 
     void setSize(int size);
 
@@ -52,6 +52,7 @@ MessageBuffer::MessageBuffer(const string &name)
     m_strict_fifo = true;
     m_max_size = 0;
     m_randomization = true;
+    m_fast_path = true;
     m_size_last_time_size_checked = 0;
     m_size_at_cycle_start = 0;
     m_msgs_this_cycle = 0;
@@ -59,11 +60,30 @@ MessageBuffer::MessageBuffer(const string &name)
     m_priority_rank = 0;
     m_name = name;
 
-    m_stall_msg_map.clear();
     m_input_link_id = 0;
     m_vnet_id = 0;
     m_toNet = false;
     m_fromNet = false;
+
+    m_stalled_msgs = NULL;
+    m_stall_residency = NULL;
+}
+
+void
+MessageBuffer::regStallStats(const string& name)
+{
+    // never freed, as the other stats created while registering them
+    m_stalled_msgs = new Stats::Scalar();
+    m_stalled_msgs
+        ->name(name + ".stalled_msgs")
+        .desc("messages stalled until their address changed state")
+        .flags(Stats::nozero);
+    m_stall_residency = new Stats::Histogram();
+    m_stall_residency
+        ->init(10)
+        .name(name + ".stall_residency")
+        .desc("cycles a stalled message waited to be reanalyzed")
+        .flags(Stats::nozero | Stats::oneline);
 }
 
 unsigned int
@@ -71,7 +91,7 @@ MessageBuffer::getSize()
 {
     if (m_time_last_time_size_checked != m_receiver->curCycle()) {
         m_time_last_time_size_checked = m_receiver->curCycle();
-        m_size_last_time_size_checked = m_prio_heap.size();
+        m_size_last_time_size_checked = queueSize();
     }
 
     return m_size_last_time_size_checked;
@@ -94,7 +114,7 @@ MessageBuffer::areNSlotsAvailable(unsigned int n)
 
     if (m_time_last_time_pop < m_sender->clockEdge()) {
         // no pops this cycle - heap size is correct
-        current_size = m_prio_heap.size();
+        current_size = queueSize();
     } else {
         if (m_time_last_time_enqueue < m_sender->curCycle()) {
             // no enqueues this cycle - m_size_at_cycle_start is correct
@@ -112,7 +132,7 @@ MessageBuffer::areNSlotsAvailable(unsigned int n)
     } else {
         DPRINTF(RubyQueue, "n: %d, current_size: %d, heap size: %d, "
                 "m_max_size: %d\n",
-                n, current_size, m_prio_heap.size(), m_max_size);
+                n, current_size, queueSize(), m_max_size);
         m_not_avail_count++;
         return false;
     }
@@ -124,7 +144,7 @@ MessageBuffer::peek() const
     DPRINTF(RubyQueue, "Peeking at head of queue.\n");
     assert(isReady());
 
-    const Message* msg_ptr = m_prio_heap.front().m_msgptr.get();
+    const Message* msg_ptr = headNode().m_msgptr.get();
     assert(msg_ptr);
 
     DPRINTF(RubyQueue, "Message: %s\n", (*msg_ptr));
@@ -209,9 +229,7 @@ MessageBuffer::enqueue(MsgPtr message, Cycles delta)
 
     // Insert the message into the priority heap
     MessageBufferNode thisNode(arrival_time, m_msg_counter, message);
-    m_prio_heap.push_back(thisNode);
-    push_heap(m_prio_heap.begin(), m_prio_heap.end(),
-        greater<MessageBufferNode>());
+    pushNode(thisNode);
 
     DPRINTF(RubyQueue, "Enqueue arrival_time: %lld, Message: %s\n",
             arrival_time, *(message.get()));
@@ -229,7 +247,7 @@ MessageBuffer::dequeue()
     assert(isReady());
 
     // get MsgPtr of the message about to be dequeued
-    MsgPtr message = m_prio_heap.front().m_msgptr;
+    MsgPtr message = headNode().m_msgptr;
 
     // get the delay cycles
     message->updateDelayedTicks(m_receiver->clockEdge());
@@ -239,13 +257,11 @@ MessageBuffer::dequeue()
     // record previous size and time so the current buffer size isn't
     // adjusted until next cycle
     if (m_time_last_time_pop < m_receiver->clockEdge()) {
-        m_size_at_cycle_start = m_prio_heap.size();
+        m_size_at_cycle_start = queueSize();
         m_time_last_time_pop = m_receiver->clockEdge();
     }
 
-    pop_heap(m_prio_heap.begin(), m_prio_heap.end(),
-        greater<MessageBufferNode>());
-    m_prio_heap.pop_back();
+    popHeadNode();
 
     return delayCycles;
 }
@@ -253,6 +269,7 @@ MessageBuffer::dequeue()
 void
 MessageBuffer::clear()
 {
+    m_in_order.clear();
     m_prio_heap.clear();
 
     m_msg_counter = 0;
@@ -267,47 +284,47 @@ MessageBuffer::recycle()
 {
     DPRINTF(RubyQueue, "Recycling.\n");
     assert(isReady());
-    MessageBufferNode node = m_prio_heap.front();
-    pop_heap(m_prio_heap.begin(), m_prio_heap.end(),
-        greater<MessageBufferNode>());
+    MessageBufferNode node = headNode();
+    popHeadNode();
 
     node.m_time = m_receiver->clockEdge(m_recycle_latency);
-    m_prio_heap.back() = node;
-    push_heap(m_prio_heap.begin(), m_prio_heap.end(),
-        greater<MessageBufferNode>());
+    pushNode(node);
     m_consumer->
         scheduleEventAbsolute(m_receiver->clockEdge(m_recycle_latency));
 }
 
 void
-MessageBuffer::reanalyzeList(list<MsgPtr> &lt, Tick nextTick)
+MessageBuffer::reanalyzeList(vector<StalledMsg> &lt, Tick nextTick)
 {
-    while(!lt.empty()) {
-        m_msg_counter++;
-        MessageBufferNode msgNode(nextTick, m_msg_counter, lt.front());
-
-        m_prio_heap.push_back(msgNode);
-        push_heap(m_prio_heap.begin(), m_prio_heap.end(),
-                  greater<MessageBufferNode>());
+    if (lt.empty())
+        return;
 
-        m_consumer->scheduleEventAbsolute(nextTick);
-        lt.pop_front();
+    // all of them arrive at the same tick, one wakeup is enough
+    Cycles now = m_receiver->curCycle();
+    for (unsigned int i = 0; i < lt.size(); ++i) {
+        m_msg_counter++;
+        pushNode(MessageBufferNode(nextTick, m_msg_counter, lt[i].m_msgptr));
+        if (m_stall_residency)
+            m_stall_residency->sample(now - lt[i].m_stall_time);
     }
+    lt.clear();
+
+    m_consumer->scheduleEventAbsolute(nextTick);
 }
 
 void
 MessageBuffer::reanalyzeMessages(const Address& addr)
 {
     DPRINTF(RubyQueue, "ReanalyzeMessages\n");
-    assert(m_stall_msg_map.count(addr) > 0);
+    assert(m_stall_msg_map.contains(addr));
     Tick nextTick = m_receiver->clockEdge(Cycles(1));
 
     //
     // Put all stalled messages associated with this address back on the
     // prio heap
     //
-    reanalyzeList(m_stall_msg_map[addr], nextTick);
-    m_stall_msg_map.erase(addr);
+    m_stall_msg_map.take(addr, m_reanalyzed);
+    reanalyzeList(m_reanalyzed, nextTick);
 }
 
 void
@@ -317,14 +334,10 @@ MessageBuffer::reanalyzeAllMessages()
     Tick nextTick = m_receiver->clockEdge(Cycles(1));
 
     //
-    // Put all stalled messages associated with this address back on the
-    // prio heap
+    // Put all stalled messages back on the prio heap, in one pass
     //
-    for (StallMsgMapType::iterator map_iter = m_stall_msg_map.begin();
-         map_iter != m_stall_msg_map.end(); ++map_iter) {
-        reanalyzeList(map_iter->second, nextTick);
-    }
-    m_stall_msg_map.clear();
+    m_stall_msg_map.takeAll(m_reanalyzed);
+    reanalyzeList(m_reanalyzed, nextTick);
 }
 
 void
@@ -333,7 +346,7 @@ MessageBuffer::stallMessage(const Address& addr)
     DPRINTF(RubyQueue, "Stalling due to %s\n", addr);
     assert(isReady());
     assert(addr.getOffset() == 0);
-    MsgPtr message = m_prio_heap.front().m_msgptr;
+    MsgPtr message = headNode().m_msgptr;
 
     dequeue();
 
@@ -342,7 +355,9 @@ MessageBuffer::stallMessage(const Address& addr)
     // Instead the controller is responsible to call reanalyzeMessages when
     // these addresses change state.
     //
-    (m_stall_msg_map[addr]).push_back(message);
+    m_stall_msg_map.push(addr, message, m_receiver->curCycle());
+    if (m_stalled_msgs)
+        (*m_stalled_msgs)++;
 }
 
 void
@@ -354,22 +369,27 @@ MessageBuffer::print(ostream& out) const
     }
 
     vector<MessageBufferNode> copy(m_prio_heap);
-    sort_heap(copy.begin(), copy.end(), greater<MessageBufferNode>());
+    copy.insert(copy.end(), m_in_order.begin(), m_in_order.end());
+    sort(copy.begin(), copy.end(), greater<MessageBufferNode>());
     ccprintf(out, "%s] %s", copy, m_name);
 }
 
 bool
 MessageBuffer::isReady() const
 {
-    return ((m_prio_heap.size() > 0) &&
-            (m_prio_heap.front().m_time <= m_receiver->clockEdge()));
+    return (!isEmpty() &&
+            (headNode().m_time <= m_receiver->clockEdge()));
 }
 
 bool
 MessageBuffer::functionalRead(Packet *pkt)
 {
-    // Check the priority heap and read any messages that may
+    // Check the queued messages and read any that may
     // correspond to the address in the packet.
+    for (unsigned int i = 0; i < m_in_order.size(); ++i) {
+        Message *msg = m_in_order[i].m_msgptr.get();
+        if (msg->functionalRead(pkt)) return true;
+    }
     for (unsigned int i = 0; i < m_prio_heap.size(); ++i) {
         Message *msg = m_prio_heap[i].m_msgptr.get();
         if (msg->functionalRead(pkt)) return true;
@@ -377,18 +397,7 @@ MessageBuffer::functionalRead(Packet *pkt)
 
     // Read the messages in the stall queue that correspond
     // to the address in the packet.
-    for (StallMsgMapType::iterator map_iter = m_stall_msg_map.begin();
-         map_iter != m_stall_msg_map.end();
-         ++map_iter) {
-
-        for (std::list<MsgPtr>::iterator it = (map_iter->second).begin();
-            it != (map_iter->second).end(); ++it) {
-
-            Message *msg = (*it).get();
-            if (msg->functionalRead(pkt)) return true;
-        }
-    }
-    return false;
+    return m_stall_msg_map.functionalRead(pkt);
 }
 
 uint32_t
@@ -396,8 +405,14 @@ MessageBuffer::functionalWrite(Packet *pkt)
 {
     uint32_t num_functional_writes = 0;
 
-    // Check the priority heap and write any messages that may
+    // Check the queued messages and write any that may
     // correspond to the address in the packet.
+    for (unsigned int i = 0; i < m_in_order.size(); ++i) {
+        Message *msg = m_in_order[i].m_msgptr.get();
+        if (msg->functionalWrite(pkt)) {
+            num_functional_writes++;
+        }
+    }
     for (unsigned int i = 0; i < m_prio_heap.size(); ++i) {
         Message *msg = m_prio_heap[i].m_msgptr.get();
         if (msg->functionalWrite(pkt)) {
@@ -407,19 +422,7 @@ MessageBuffer::functionalWrite(Packet *pkt)
 
     // Check the stall queue and write any messages that may
     // correspond to the address in the packet.
-    for (StallMsgMapType::iterator map_iter = m_stall_msg_map.begin();
-         map_iter != m_stall_msg_map.end();
-         ++map_iter) {
-
-        for (std::list<MsgPtr>::iterator it = (map_iter->second).begin();
-            it != (map_iter->second).end(); ++it) {
-
-            Message *msg = (*it).get();
-            if (msg->functionalWrite(pkt)) {
-                num_functional_writes++;
-            }
-        }
-    }
+    num_functional_writes += m_stall_msg_map.functionalWrite(pkt);
 
     return num_functional_writes;
 }
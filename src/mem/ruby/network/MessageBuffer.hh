@@ -29,6 +29,12 @@
 /*
  * Unordered buffer of messages that can be inserted such
  * that they can be dequeued after a given delta time has expired.
+ *
+ * Messages are kept ordered by arrival time. As most of them are
+ * enqueued with the same small delay, they usually arrive in order and
+ * go to a FIFO lane with O(1) enqueue and dequeue. Only a message due
+ * before the last one in the lane goes to the priority heap, and the
+ * head of the buffer is the earlier of the two heads.
  */
 
 #ifndef __MEM_RUBY_BUFFERS_MESSAGEBUFFER_HH__
@@ -36,14 +42,17 @@
 
 #include <algorithm>
 #include <cassert>
+#include <deque>
 #include <functional>
 #include <iostream>
 #include <string>
 #include <vector>
 
+#include "base/statistics.hh"
 #include "mem/ruby/common/Address.hh"
 #include "mem/ruby/common/Consumer.hh"
 #include "mem/ruby/network/MessageBufferNode.hh"
+#include "mem/ruby/network/StallMsgTable.hh"
 #include "mem/ruby/slicc_interface/Message.hh"
 #include "mem/packet.hh"
 
@@ -67,11 +76,9 @@ class MessageBuffer
     void
     delayHead()
     {
-        MessageBufferNode node = m_prio_heap.front();
-        std::pop_heap(m_prio_heap.begin(), m_prio_heap.end(),
-                      std::greater<MessageBufferNode>());
-        m_prio_heap.pop_back();
-        enqueue(node.m_msgptr, Cycles(1));
+        MsgPtr message = headNode().m_msgptr;
+        popHeadNode();
+        enqueue(message, Cycles(1));
     }
 
     bool areNSlotsAvailable(unsigned int n);
@@ -112,7 +119,7 @@ class MessageBuffer
     peekMsgPtr() const
     {
         assert(isReady());
-        return m_prio_heap.front().m_msgptr;
+        return headNode().m_msgptr;
     }
 
     void enqueue(MsgPtr message) { enqueue(message, Cycles(1)); }
@@ -123,7 +130,7 @@ class MessageBuffer
     Cycles dequeue();
 
     void recycle();
-    bool isEmpty() const { return m_prio_heap.size() == 0; }
+    bool isEmpty() const { return m_in_order.empty() && m_prio_heap.empty(); }
 
     void
     setOrdering(bool order)
@@ -135,10 +142,15 @@ class MessageBuffer
     void resize(unsigned int size) { m_max_size = size; }
     unsigned int getSize();
     void setRandomization(bool random_flag) { m_randomization = random_flag; }
+    // with the fast path off every message goes through the heap
+    void setFastPath(bool fast_path) { m_fast_path = fast_path; }
 
     void clear();
     void print(std::ostream& out) const;
     void clearStats() { m_not_avail_count = 0; m_msg_counter = 0; }
+    // allocates and names the stall stats, only done for the buffers a
+    // controller reads through an in_port, the only ones that stall
+    void regStallStats(const std::string& name);
 
     void setIncomingLink(int link_id) { m_input_link_id = link_id; }
     void setVnet(int net) { m_vnet_id = net; }
@@ -160,7 +172,48 @@ class MessageBuffer
     uint32_t functionalWrite(Packet *pkt);
 
   private:
-    void reanalyzeList(std::list<MsgPtr> &, Tick);
+    void reanalyzeList(std::vector<StalledMsg> &, Tick);
+
+    unsigned int queueSize() const
+    { return m_in_order.size() + m_prio_heap.size(); }
+
+    bool
+    headInOrder() const
+    {
+        return m_prio_heap.empty() ||
+            (!m_in_order.empty() && m_prio_heap.front() > m_in_order.front());
+    }
+
+    const MessageBufferNode&
+    headNode() const
+    {
+        return headInOrder() ? m_in_order.front() : m_prio_heap.front();
+    }
+
+    void
+    pushNode(const MessageBufferNode& node)
+    {
+        if (m_fast_path &&
+            (m_in_order.empty() || node > m_in_order.back())) {
+            m_in_order.push_back(node);
+            return;
+        }
+        m_prio_heap.push_back(node);
+        std::push_heap(m_prio_heap.begin(), m_prio_heap.end(),
+                       std::greater<MessageBufferNode>());
+    }
+
+    void
+    popHeadNode()
+    {
+        if (headInOrder()) {
+            m_in_order.pop_front();
+            return;
+        }
+        std::pop_heap(m_prio_heap.begin(), m_prio_heap.end(),
+                      std::greater<MessageBufferNode>());
+        m_prio_heap.pop_back();
+    }
 
   private:
     //added by SS
@@ -173,13 +226,14 @@ class MessageBuffer
 
     //! Consumer to signal a wakeup(), can be NULL
     Consumer* m_consumer;
+    //! messages in arrival order, and the ones that arrived out of order
+    std::deque<MessageBufferNode> m_in_order;
     std::vector<MessageBufferNode> m_prio_heap;
 
-    // use a std::map for the stalled messages as this container is
-    // sorted and ensures a well-defined iteration order
-    typedef std::map< Address, std::list<MsgPtr> > StallMsgMapType;
-
-    StallMsgMapType m_stall_msg_map;
+    //! messages stalled on each address until they are reanalyzed
+    StallMsgTable m_stall_msg_map;
+    //! scratch list of the messages being reanalyzed
+    std::vector<StalledMsg> m_reanalyzed;
     std::string m_name;
 
     unsigned int m_max_size;
@@ -202,11 +256,17 @@ class MessageBuffer
     bool m_strict_fifo;
     bool m_ordering_set;
     bool m_randomization;
+    bool m_fast_path;
 
     int m_input_link_id;
     int m_vnet_id;
     bool m_toNet;
     bool m_fromNet;
+
+    //! Messages stalled, and the cycles they waited until reanalyzed,
+    //! NULL until regStallStats
+    Stats::Scalar *m_stalled_msgs;
+    Stats::Histogram *m_stall_residency;
 };
 
 Cycles random_time();
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2026 The University of Cantabria (Spain)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cassert>
+
+#include "mem/ruby/network/PortRoutingTable.hh"
+
+using namespace std;
+
+PortRoutingTable::PortRoutingTable()
+    : m_links(0)
+{
+}
+
+void
+PortRoutingTable::addLink(const NetDest& routing_table_entry)
+{
+    if (m_node_machine.empty()) {
+        for (int m = 0; m < MachineType_NUM; m++) {
+            MachineType type = (MachineType)m;
+            for (NodeID i = 0; i < MachineType_base_count(type); i++) {
+                MachineID mach = {type, i};
+                m_node_machine.push_back(mach);
+            }
+        }
+        m_node_links.resize(m_node_machine.size());
+    }
+
+    LinkID link = m_links++;
+    m_link_slot.push_back(-1);
+
+    m_nodes.clear();
+    routing_table_entry.getAllDest(m_nodes);
+    for (int i = 0; i < m_nodes.size(); i++)
+        m_node_links[m_nodes[i]].push_back(link);
+}
+
+bool
+PortRoutingTable::before(LinkID l1, LinkID l2,
+                         const vector<int>* link_value) const
+{
+    if (link_value != NULL && (*link_value)[l1] != (*link_value)[l2])
+        return (*link_value)[l1] < (*link_value)[l2];
+    return l1 < l2;
+}
+
+void
+PortRoutingTable::route(const NetDest& dsts, const vector<int>* link_value,
+                        vector<LinkID>& links,
+                        vector<NetDest>& link_destinations)
+{
+    m_nodes.clear();
+    dsts.getAllDest(m_nodes);
+
+    for (int i = 0; i < m_nodes.size(); i++) {
+        const vector<LinkID>& candidates = m_node_links[m_nodes[i]];
+        assert(!candidates.empty());
+
+        LinkID link = candidates[0];
+        if (link_value != NULL) {
+            for (int c = 1; c < candidates.size(); c++) {
+                if (before(candidates[c], link, link_value))
+                    link = candidates[c];
+            }
+        }
+
+        if (m_link_slot[link] == -1) {
+            m_link_slot[link] = links.size();
+            links.push_back(link);
+            link_destinations.push_back(NetDest());
+        }
+        link_destinations[m_link_slot[link]].add(m_node_machine[m_nodes[i]]);
+    }
+
+    // a message rarely leaves by more than a few links, insertion sort
+    // them into routing order
+    for (int i = 0; i < links.size(); i++) {
+        m_link_slot[links[i]] = -1;
+        for (int j = i; j > 0 && before(links[j], links[j - 1], link_value);
+             j--) {
+            swap(links[j], links[j - 1]);
+            swap(link_destinations[j], link_destinations[j - 1]);
+        }
+    }
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2026 The University of Cantabria (Spain)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Routing table of a switch, kept per destination: for every node, the
+ * output links whose routing table entry reaches it. A message is split
+ * among the links by looking up its destinations, instead of intersecting
+ * its whole destination set with the entry of every link.
+ */
+
+#ifndef __MEM_RUBY_NETWORK_PORTROUTINGTABLE_HH__
+#define __MEM_RUBY_NETWORK_PORTROUTINGTABLE_HH__
+
+#include <vector>
+
+#include "mem/ruby/common/NetDest.hh"
+#include "mem/ruby/common/TypeDefines.hh"
+
+class PortRoutingTable
+{
+  public:
+    PortRoutingTable();
+
+    //! Adds the next output link, numbered in the order they are added
+    void addLink(const NetDest& routing_table_entry);
+    int getLinks() const { return m_links; }
+
+    //! Splits dsts among the output links. Every destination goes to the
+    //! first link reaching it, in the order of increasing link_value (or
+    //! of link number when NULL, or to break ties), and the links used
+    //! are returned in that order with the destinations each one serves.
+    void route(const NetDest& dsts, const std::vector<int>* link_value,
+               std::vector<LinkID>& links,
+               std::vector<NetDest>& link_destinations);
+
+  private:
+    bool before(LinkID l1, LinkID l2,
+                const std::vector<int>* link_value) const;
+
+    int m_links;
+    //! maps each node number to its MachineID
+    std::vector<MachineID> m_node_machine;
+    //! links reaching each node, by increasing link number
+    std::vector<std::vector<LinkID> > m_node_links;
+
+    //! position of each link in the output of route(), -1 if unused
+    std::vector<int> m_link_slot;
+    std::vector<NodeID> m_nodes;
+};
+
+#endif // __MEM_RUBY_NETWORK_PORTROUTINGTABLE_HH__
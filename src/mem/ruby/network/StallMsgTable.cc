@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2026 The University of Cantabria (Spain)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+
+#include "base/intmath.hh"
+#include "base/misc.hh"
+#include "mem/ruby/network/StallMsgTable.hh"
+
+using namespace std;
+
+// starting number of slots, a power of two
+static const unsigned int INITIAL_SLOTS = 16;
+
+StallMsgTable::StallMsgTable()
+    : m_slots(INITIAL_SLOTS), m_mask(INITIAL_SLOTS - 1),
+      m_shift(64 - floorLog2(INITIAL_SLOTS)), m_addresses(0),
+      m_free_nodes(-1)
+{
+    for (unsigned int i = 0; i < m_slots.size(); i++)
+        m_slots[i].m_head = -1;
+}
+
+unsigned int
+StallMsgTable::home(const Address& addr) const
+{
+    // line addresses have their low bits clear, so use the high bits of
+    // a multiplicative hash rather than the address itself
+    uint64_t hash = addr.getAddress() * ULL(0x9e3779b97f4a7c15);
+    return hash >> m_shift;
+}
+
+int
+StallMsgTable::find(const Address& addr) const
+{
+    for (unsigned int i = home(addr); ; i = (i + 1) & m_mask) {
+        const Slot& slot = m_slots[i];
+        if (slot.m_head == -1)
+            return -1;
+        if (slot.m_addr == addr)
+            return i;
+    }
+}
+
+bool
+StallMsgTable::contains(const Address& addr) const
+{
+    return find(addr) != -1;
+}
+
+int
+StallMsgTable::allocateNode()
+{
+    if (m_free_nodes == -1) {
+        m_nodes.push_back(StalledMsg());
+        return m_nodes.size() - 1;
+    }
+    int node = m_free_nodes;
+    m_free_nodes = m_nodes[node].m_next;
+    return node;
+}
+
+void
+StallMsgTable::grow()
+{
+    vector<Slot> old_slots;
+    old_slots.swap(m_slots);
+    m_slots.resize(2 * old_slots.size());
+    m_mask = m_slots.size() - 1;
+    m_shift--;
+    for (unsigned int i = 0; i < m_slots.size(); i++)
+        m_slots[i].m_head = -1;
+
+    for (unsigned int i = 0; i < old_slots.size(); i++) {
+        if (old_slots[i].m_head == -1)
+            continue;
+        unsigned int j = home(old_slots[i].m_addr);
+        while (m_slots[j].m_head != -1)
+            j = (j + 1) & m_mask;
+        m_slots[j] = old_slots[i];
+    }
+}
+
+void
+StallMsgTable::push(const Address& addr, const MsgPtr& message, Cycles now)
+{
+    int node = allocateNode();
+    m_nodes[node].m_msgptr = message;
+    m_nodes[node].m_stall_time = now;
+    m_nodes[node].m_next = -1;
+
+    int found = find(addr);
+    if (found != -1) {
+        Slot& slot = m_slots[found];
+        m_nodes[slot.m_tail].m_next = node;
+        slot.m_tail = node;
+        return;
+    }
+
+    // keep the load under one half so that probe sequences stay short
+    if (2 * (m_addresses + 1) > m_slots.size())
+        grow();
+
+    unsigned int i = home(addr);
+    while (m_slots[i].m_head != -1)
+        i = (i + 1) & m_mask;
+    m_slots[i].m_addr = addr;
+    m_slots[i].m_head = node;
+    m_slots[i].m_tail = node;
+    m_addresses++;
+}
+
+void
+StallMsgTable::releaseChain(int head, vector<StalledMsg>& out)
+{
+    for (int node = head; node != -1; ) {
+        StalledMsg& stalled = m_nodes[node];
+        out.push_back(stalled);
+        out.back().m_next = -1;
+        stalled.m_msgptr = NULL;
+
+        int next = stalled.m_next;
+        stalled.m_next = m_free_nodes;
+        m_free_nodes = node;
+        node = next;
+    }
+}
+
+void
+StallMsgTable::erase(unsigned int hole)
+{
+    // shift back the entries that probed past the hole, so that lookups
+    // never need tombstones
+    for (unsigned int i = (hole + 1) & m_mask; m_slots[i].m_head != -1;
+         i = (i + 1) & m_mask) {
+        unsigned int wanted = home(m_slots[i].m_addr);
+        // move it unless its home lies cyclically in (hole, i]
+        bool stays = (hole < i) ? (wanted > hole && wanted <= i)
+                                : (wanted > hole || wanted <= i);
+        if (!stays) {
+            m_slots[hole] = m_slots[i];
+            hole = i;
+        }
+    }
+    m_slots[hole].m_head = -1;
+    m_addresses--;
+}
+
+void
+StallMsgTable::take(const Address& addr, vector<StalledMsg>& out)
+{
+    int found = find(addr);
+    assert(found != -1);
+    releaseChain(m_slots[found].m_head, out);
+    erase(found);
+}
+
+static bool
+slotAddressLess(const pair<Address, int>& a, const pair<Address, int>& b)
+{
+    return a.first < b.first;
+}
+
+void
+StallMsgTable::takeAll(vector<StalledMsg>& out)
+{
+    if (m_addresses == 0)
+        return;
+
+    // wake up the addresses in the order the old sorted map used, which
+    // keeps the simulation independent of the hash
+    vector<pair<Address, int> > heads;
+    heads.reserve(m_addresses);
+    for (unsigned int i = 0; i < m_slots.size(); i++) {
+        if (m_slots[i].m_head != -1) {
+            heads.push_back(make_pair(m_slots[i].m_addr, m_slots[i].m_head));
+            m_slots[i].m_head = -1;
+        }
+    }
+    sort(heads.begin(), heads.end(), slotAddressLess);
+
+    for (unsigned int i = 0; i < heads.size(); i++)
+        releaseChain(heads[i].second, out);
+    m_addresses = 0;
+}
+
+void
+StallMsgTable::clear()
+{
+    for (unsigned int i = 0; i < m_slots.size(); i++)
+        m_slots[i].m_head = -1;
+    m_addresses = 0;
+    m_nodes.clear();
+    m_free_nodes = -1;
+}
+
+bool
+StallMsgTable::functionalRead(Packet *pkt)
+{
+    for (unsigned int i = 0; i < m_nodes.size(); ++i) {
+        Message *msg = m_nodes[i].m_msgptr.get();
+        if (msg != NULL && msg->functionalRead(pkt))
+            return true;
+    }
+    return false;
+}
+
+uint32_t
+StallMsgTable::functionalWrite(Packet *pkt)
+{
+    uint32_t num_functional_writes = 0;
+    for (unsigned int i = 0; i < m_nodes.size(); ++i) {
+        Message *msg = m_nodes[i].m_msgptr.get();
+        if (msg != NULL && msg->functionalWrite(pkt))
+            num_functional_writes++;
+    }
+    return num_functional_writes;
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2026 The University of Cantabria (Spain)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Messages stalled by a controller, kept per line address until the
+ * controller reanalyzes them. An open-addressing table (linear probing,
+ * backward-shift deletion) maps each address to an intrusive chain of
+ * nodes taken from a pool, so stalling and waking up a line neither walks
+ * a tree nor allocates once the pool has grown.
+ */
+
+#ifndef __MEM_RUBY_NETWORK_STALLMSGTABLE_HH__
+#define __MEM_RUBY_NETWORK_STALLMSGTABLE_HH__
+
+#include <vector>
+
+#include "mem/ruby/common/Address.hh"
+#include "mem/ruby/slicc_interface/Message.hh"
+#include "mem/packet.hh"
+#include "sim/clocked_object.hh"
+
+struct StalledMsg
+{
+    MsgPtr m_msgptr;
+    //! cycle of the receiver when the message was stalled
+    Cycles m_stall_time;
+    //! next node of the same address, or of the free list
+    int m_next;
+};
+
+class StallMsgTable
+{
+  public:
+    StallMsgTable();
+
+    bool empty() const { return m_addresses == 0; }
+    bool contains(const Address& addr) const;
+
+    //! Appends a message to the chain of its address
+    void push(const Address& addr, const MsgPtr& message, Cycles now);
+
+    //! Moves the messages stalled on addr, in stall order, to the end of
+    //! out and forgets the address
+    void take(const Address& addr, std::vector<StalledMsg>& out);
+
+    //! Moves every stalled message to out, by increasing address and in
+    //! stall order within an address, and empties the table
+    void takeAll(std::vector<StalledMsg>& out);
+
+    void clear();
+
+    bool functionalRead(Packet *pkt);
+    uint32_t functionalWrite(Packet *pkt);
+
+  private:
+    struct Slot
+    {
+        Address m_addr;
+        //! first and last node of the chain, -1 when the slot is empty
+        int m_head;
+        int m_tail;
+    };
+
+    unsigned int home(const Address& addr) const;
+    int find(const Address& addr) const;
+    void erase(unsigned int slot);
+    void grow();
+    int allocateNode();
+    void releaseChain(int head, std::vector<StalledMsg>& out);
+
+    std::vector<Slot> m_slots;
+    unsigned int m_mask;
+    unsigned int m_shift;
+    unsigned int m_addresses;
+
+    std::vector<StalledMsg> m_nodes;
+    int m_free_nodes;
+};
+
+#endif // __MEM_RUBY_NETWORK_STALLMSGTABLE_HH__
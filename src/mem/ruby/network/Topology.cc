@@ -26,7 +26,12 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <algorithm>
 #include <cassert>
+#include <climits>
+#include <functional>
+#include <queue>
+#include <thread>
 
 #include "base/trace.hh"
 #include "debug/RubyNetwork.hh"
@@ -39,6 +44,11 @@ using namespace std;
 
 const int INFINITE_LATENCY = 10000; // Yes, this is a big hack
 
+// Fewest sources worth a host thread of their own. A search from one
+// source takes microseconds on the usual topologies, about what it takes
+// to start a thread, so small networks are searched on the caller alone.
+const int SOURCES_PER_THREAD = 64;
+
 // Note: In this file, we use the first 2*m_nodes SwitchIDs to
 // represent the input and output endpoint links.  These really are
 // not 'switches', as they will not have a Switch object allocated for
@@ -46,10 +56,20 @@ const int INFINITE_LATENCY = 10000; // Yes, this is a big hack
 // the second m_nodes set of SwitchIDs represent the the output queues
 // of the network.
 
-// Helper functions based on chapter 29 of Cormen et al.
-void extend_shortest_path(Matrix& current_dist, Matrix& latencies,
+// A unidirectional link as seen by the shortest path search
+struct PathLink
+{
+    SwitchID m_dest;
+    int m_weight;
+    int m_latency;
+};
+
+typedef std::vector<std::vector<PathLink> > LinkGraph;
+
+void shortest_paths_from(SwitchID src, const LinkGraph& graph,
+    bool uniform_weights, Matrix& dist, Matrix& latencies,
     Matrix& inter_switches);
-Matrix shortest_path(const Matrix& weights, Matrix& latencies,
+Matrix shortest_path(const LinkGraph& graph, Matrix& latencies,
     Matrix& inter_switches);
 bool link_is_shortest_path_to_node(SwitchID src, SwitchID next,
     SwitchID final, const Matrix& weights, const Matrix& dist);
@@ -162,6 +182,7 @@ Topology::createLinks(Network *net)
     }
 
     // Fill in the topology weights and bandwidth multipliers
+    LinkGraph graph(num_switches);
     for (LinkMap::const_iterator i = m_link_map.begin();
          i != m_link_map.end(); ++i) {
         std::pair<int, int> src_dest = (*i).first;
@@ -170,10 +191,14 @@ Topology::createLinks(Network *net)
         int dst = src_dest.second;
         m_component_latencies[src][dst] = link->m_latency;
         topology_weights[src][dst] = link->m_weight;
+
+        PathLink path_link = { (SwitchID)dst, link->m_weight,
+                               (int)link->m_latency };
+        graph[src].push_back(path_link);
     }
-        
+
     // Walk topology and hookup the links
-    Matrix dist = shortest_path(topology_weights, m_component_latencies,
+    Matrix dist = shortest_path(graph, m_component_latencies,
         m_component_inter_switches);
     for (int i = 0; i < topology_weights.size(); i++) {
         for (int j = 0; j < topology_weights[i].size(); j++) {
@@ -248,51 +273,108 @@ Topology::makeLink(Network *net, SwitchID src, SwitchID dest,
     }
 }
 
-// The following all-pairs shortest path algorithm is based on the
-// discussion from Cormen et al., Chapter 26.1.
+// Single-source shortest paths from src, one search per source instead
+// of the all-pairs relaxation of Cormen et al., Chapter 26.1. Only row
+// src of the matrices is written, so sources can be searched in
+// parallel. Distances are capped at INFINITE_LATENCY like the weights of
+// missing links, which keeps the routing tables the relaxation built.
 void
-extend_shortest_path(Matrix& current_dist, Matrix& latencies,
+shortest_paths_from(SwitchID src, const LinkGraph& graph,
+    bool uniform_weights, Matrix& dist, Matrix& latencies,
     Matrix& inter_switches)
 {
-    bool change = true;
-    int nodes = current_dist.size();
-
-    while (change) {
-        change = false;
-        for (int i = 0; i < nodes; i++) {
-            for (int j = 0; j < nodes; j++) {
-                int minimum = current_dist[i][j];
-                int previous_minimum = minimum;
-                int intermediate_switch = -1;
-                for (int k = 0; k < nodes; k++) {
-                    minimum = min(minimum,
-                        current_dist[i][k] + current_dist[k][j]);
-                    if (previous_minimum != minimum) {
-                        intermediate_switch = k;
-                        inter_switches[i][j] =
-                            inter_switches[i][k] +
-                            inter_switches[k][j] + 1;
-                    }
-                    previous_minimum = minimum;
-                }
-                if (current_dist[i][j] != minimum) {
-                    change = true;
-                    current_dist[i][j] = minimum;
-                    assert(intermediate_switch >= 0);
-                    assert(intermediate_switch < latencies[i].size());
-                    latencies[i][j] = latencies[i][intermediate_switch] +
-                        latencies[intermediate_switch][j];
-                }
+    int nodes = graph.size();
+    vector<int> distance(nodes, INT_MAX);
+    vector<int> latency(nodes, -1);
+    vector<int> hops(nodes, 0);
+    distance[src] = 0;
+
+    if (uniform_weights) {
+        // every link weighs the same, a breadth first search is enough
+        vector<SwitchID> frontier(1, src);
+        for (int head = 0; head < frontier.size(); head++) {
+            SwitchID u = frontier[head];
+            for (int l = 0; l < graph[u].size(); l++) {
+                const PathLink& link = graph[u][l];
+                if (distance[link.m_dest] != INT_MAX)
+                    continue;
+                distance[link.m_dest] = distance[u] + link.m_weight;
+                latency[link.m_dest] = max(latency[u], 0) + link.m_latency;
+                hops[link.m_dest] = hops[u] + 1;
+                frontier.push_back(link.m_dest);
+            }
+        }
+    } else {
+        typedef pair<int, SwitchID> QueueEntry;
+        priority_queue<QueueEntry, vector<QueueEntry>,
+                       greater<QueueEntry> > queue;
+        queue.push(QueueEntry(0, src));
+        while (!queue.empty()) {
+            QueueEntry top = queue.top();
+            queue.pop();
+            SwitchID u = top.second;
+            if (top.first != distance[u])
+                continue;
+            for (int l = 0; l < graph[u].size(); l++) {
+                const PathLink& link = graph[u][l];
+                int through_u = distance[u] + link.m_weight;
+                if (through_u >= distance[link.m_dest])
+                    continue;
+                distance[link.m_dest] = through_u;
+                latency[link.m_dest] = max(latency[u], 0) + link.m_latency;
+                hops[link.m_dest] = hops[u] + 1;
+                queue.push(QueueEntry(through_u, link.m_dest));
             }
         }
     }
+
+    for (int j = 0; j < nodes; j++) {
+        if (j == src || distance[j] >= INFINITE_LATENCY) {
+            dist[src][j] = (j == src) ? 0 : INFINITE_LATENCY;
+            continue;
+        }
+        dist[src][j] = distance[j];
+        latencies[src][j] = latency[j];
+        inter_switches[src][j] = hops[j] - 1;
+    }
 }
 
 Matrix
-shortest_path(const Matrix& weights, Matrix& latencies, Matrix& inter_switches)
+shortest_path(const LinkGraph& graph, Matrix& latencies,
+    Matrix& inter_switches)
 {
-    Matrix dist = weights;
-    extend_shortest_path(dist, latencies, inter_switches);
+    int nodes = graph.size();
+    Matrix dist(nodes, vector<int>(nodes, INFINITE_LATENCY));
+
+    bool uniform_weights = true;
+    int weight = -1;
+    for (int i = 0; i < nodes; i++) {
+        for (int l = 0; l < graph[i].size(); l++) {
+            if (weight == -1)
+                weight = graph[i][l].m_weight;
+            uniform_weights &= graph[i][l].m_weight == weight;
+        }
+    }
+
+    // split the sources among the host threads, each of them writes
+    // only the rows of its own sources
+    int threads = min((int)thread::hardware_concurrency(),
+                      nodes / SOURCES_PER_THREAD);
+    threads = max(threads, 1);
+    vector<thread> workers;
+    for (int t = 1; t < threads; t++) {
+        workers.push_back(thread([&, t]() {
+            for (SwitchID src = t; src < nodes; src += threads)
+                shortest_paths_from(src, graph, uniform_weights, dist,
+                                    latencies, inter_switches);
+        }));
+    }
+    for (SwitchID src = 0; src < nodes; src += threads)
+        shortest_paths_from(src, graph, uniform_weights, dist, latencies,
+                            inter_switches);
+    for (int t = 0; t < workers.size(); t++)
+        workers[t].join();
+
     return dist;
 }
 
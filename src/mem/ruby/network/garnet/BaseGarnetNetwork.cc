@@ -140,4 +140,8 @@ BaseGarnetNetwork::regStats()
 
     m_avg_latency.name(name() + ".average_latency");
     m_avg_latency = m_avg_network_latency + m_avg_queueing_latency;
+
+    m_flit_allocations.name(name() + ".flit_allocations");
+    m_flit_slabs.name(name() + ".flit_slabs");
+    m_peak_flits_in_use.name(name() + ".peak_flits_in_use");
 }
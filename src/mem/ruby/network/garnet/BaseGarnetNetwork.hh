@@ -98,6 +98,11 @@ class BaseGarnetNetwork : public Network
     Stats::Formula m_avg_network_latency;
     Stats::Formula m_avg_queueing_latency;
     Stats::Formula m_avg_latency;
+
+    // filled in by the flit allocator of the network
+    Stats::Scalar m_flit_allocations;
+    Stats::Scalar m_flit_slabs;
+    Stats::Scalar m_peak_flits_in_use;
 };
 
 #endif // __MEM_RUBY_NETWORK_GARNET_BASEGARNETNETWORK_HH__
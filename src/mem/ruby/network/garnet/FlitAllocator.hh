@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2026 The University of Cantabria (Spain)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __MEM_RUBY_NETWORK_GARNET_FLIT_ALLOCATOR_HH__
+#define __MEM_RUBY_NETWORK_GARNET_FLIT_ALLOCATOR_HH__
+
+#include <cassert>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+ * Hands out the flits of one network from slabs of preallocated storage
+ * and recycles the ones destroyed, so that steady-state traffic does
+ * not go to the heap at all. Flits still in flight when the network is
+ * deleted are dropped along with their slabs, as they were leaked before.
+ */
+template <class T>
+class FlitAllocator
+{
+  public:
+    FlitAllocator(int flits_per_slab = 1024)
+        : m_flits_per_slab(flits_per_slab), m_free(NULL),
+          m_allocations(0), m_in_use(0), m_peak_in_use(0)
+    {
+        assert(m_flits_per_slab > 0);
+    }
+
+    ~FlitAllocator()
+    {
+        for (int i = 0; i < m_slabs.size(); i++)
+            delete [] m_slabs[i];
+    }
+
+    template <typename... Args>
+    T *
+    create(Args&&... args)
+    {
+        if (m_free == NULL)
+            addSlab();
+
+        Slot *slot = m_free;
+        m_free = slot->next;
+
+        m_allocations++;
+        if (++m_in_use > m_peak_in_use)
+            m_peak_in_use = m_in_use;
+
+        return new (&slot->storage) T(std::forward<Args>(args)...);
+    }
+
+    void
+    destroy(T *flit)
+    {
+        flit->~T();
+
+        Slot *slot = reinterpret_cast<Slot *>(flit);
+        slot->next = m_free;
+        m_free = slot;
+        m_in_use--;
+    }
+
+    double get_allocation_count() const { return m_allocations; }
+    double get_slab_count() const { return m_slabs.size(); }
+    double get_peak_in_use() const { return m_peak_in_use; }
+
+  private:
+    union Slot
+    {
+        Slot *next;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    };
+
+    void
+    addSlab()
+    {
+        Slot *slab = new Slot[m_flits_per_slab];
+        for (int i = 0; i < m_flits_per_slab - 1; i++)
+            slab[i].next = &slab[i + 1];
+        slab[m_flits_per_slab - 1].next = m_free;
+        m_free = slab;
+        m_slabs.push_back(slab);
+    }
+
+    // Private copy constructor and assignment operator
+    FlitAllocator(const FlitAllocator& obj);
+    FlitAllocator& operator=(const FlitAllocator& obj);
+
+    int m_flits_per_slab;
+    std::vector<Slot *> m_slabs;
+    Slot *m_free;
+
+    double m_allocations;
+    int m_in_use;
+    int m_peak_in_use;
+};
+
+#endif // __MEM_RUBY_NETWORK_GARNET_FLIT_ALLOCATOR_HH__
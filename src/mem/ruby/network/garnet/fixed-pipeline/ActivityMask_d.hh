@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2026 The University of Cantabria (Spain)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __MEM_RUBY_NETWORK_GARNET_FIXED_PIPELINE_ACTIVITY_MASK_D_HH__
+#define __MEM_RUBY_NETWORK_GARNET_FIXED_PIPELINE_ACTIVITY_MASK_D_HH__
+
+#include <cassert>
+#include <vector>
+
+#include "base/bitfield.hh"
+#include "base/types.hh"
+
+/*
+ * The VCs or ports of a router that currently have work, kept as a
+ * bitmap so that the allocators walk the set ones only. Members are
+ * visited in increasing order, or cyclically from a round robin pointer.
+ */
+class ActivityMask_d
+{
+  public:
+    ActivityMask_d() : m_size(0), m_count(0) {}
+
+    void
+    resize(int size)
+    {
+        m_size = size;
+        m_count = 0;
+        m_words.assign((size + 63) / 64, 0);
+    }
+
+    int size() const { return m_size; }
+    bool empty() const { return m_count == 0; }
+
+    bool
+    test(int i) const
+    {
+        assert(i >= 0 && i < m_size);
+        return (m_words[i / 64] >> (i % 64)) & 1;
+    }
+
+    void
+    set(int i)
+    {
+        if (!test(i)) {
+            m_words[i / 64] |= (uint64_t)1 << (i % 64);
+            m_count++;
+        }
+    }
+
+    void
+    clear(int i)
+    {
+        if (test(i)) {
+            m_words[i / 64] &= ~((uint64_t)1 << (i % 64));
+            m_count--;
+        }
+    }
+
+    void
+    clear()
+    {
+        for (int w = 0; w < m_words.size(); w++)
+            m_words[w] = 0;
+        m_count = 0;
+    }
+
+    // the first member at or after i, or size() if there is none
+    int
+    next(int i) const
+    {
+        if (i >= m_size)
+            return m_size;
+
+        int w = i / 64;
+        uint64_t word = m_words[w] & (~(uint64_t)0 << (i % 64));
+        while (word == 0) {
+            if (++w == m_words.size())
+                return m_size;
+            word = m_words[w];
+        }
+        return w * 64 + findLsbSet(word);
+    }
+
+    // like next(), but wraps around to the first member
+    int
+    nextCyclic(int i) const
+    {
+        int member = next(i);
+        return member < m_size ? member : next(0);
+    }
+
+  private:
+    int m_size;
+    int m_count;
+    std::vector<uint64_t> m_words;
+};
+
+#endif // __MEM_RUBY_NETWORK_GARNET_FIXED_PIPELINE_ACTIVITY_MASK_D_HH__
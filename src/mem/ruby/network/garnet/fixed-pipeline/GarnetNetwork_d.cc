@@ -212,6 +212,7 @@ GarnetNetwork_d::regStats()
     BaseGarnetNetwork::regStats();
     regLinkStats();
     regPowerStats();
+    regRouterStats();
 }
 
 void
@@ -245,11 +246,23 @@ GarnetNetwork_d::regPowerStats()
                            m_clk_power;
 }
 
+void
+GarnetNetwork_d::regRouterStats()
+{
+    // wakeups of the router pipeline stages per flit switched
+    m_router_evaluations.name(name() + ".router_evaluations");
+    m_router_flits.name(name() + ".router_flits");
+
+    m_evaluations_per_flit.name(name() + ".router_evaluations_per_flit");
+    m_evaluations_per_flit = m_router_evaluations / m_router_flits;
+}
+
 void
 GarnetNetwork_d::collateStats()
 {
     collateLinkStats();
     collatePowerStats();
+    collateRouterStats();
 }
 
 void
@@ -286,6 +299,19 @@ GarnetNetwork_d::collatePowerStats()
     }
 }
 
+void
+GarnetNetwork_d::collateRouterStats()
+{
+    for (int i = 0; i < m_routers.size(); i++) {
+        m_router_evaluations += m_routers[i]->get_evaluation_count();
+        m_router_flits += m_routers[i]->get_flit_count();
+    }
+
+    m_flit_allocations = m_flit_allocator.get_allocation_count();
+    m_flit_slabs = m_flit_allocator.get_slab_count();
+    m_peak_flits_in_use = m_flit_allocator.get_peak_in_use();
+}
+
 void
 GarnetNetwork_d::print(ostream& out) const
 {
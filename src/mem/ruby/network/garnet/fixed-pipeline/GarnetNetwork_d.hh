@@ -35,6 +35,8 @@
 #include <vector>
 
 #include "mem/ruby/network/garnet/BaseGarnetNetwork.hh"
+#include "mem/ruby/network/garnet/fixed-pipeline/flit_d.hh"
+#include "mem/ruby/network/garnet/FlitAllocator.hh"
 #include "mem/ruby/network/garnet/NetworkHeader.hh"
 #include "params/GarnetNetwork_d.hh"
 
@@ -56,6 +58,7 @@ class GarnetNetwork_d : public BaseGarnetNetwork
 
     int getBuffersPerDataVC() {return m_buffers_per_data_vc; }
     int getBuffersPerCtrlVC() {return m_buffers_per_ctrl_vc; }
+    FlitAllocator<flit_d>& getFlitAllocator() { return m_flit_allocator; }
 
     void collateStats();
     void regStats();
@@ -92,8 +95,10 @@ class GarnetNetwork_d : public BaseGarnetNetwork
 
     void collateLinkStats();
     void collatePowerStats();
+    void collateRouterStats();
     void regLinkStats();
     void regPowerStats();
+    void regRouterStats();
 
     std::vector<VNET_type > m_vnet_type;
 
@@ -105,6 +110,8 @@ class GarnetNetwork_d : public BaseGarnetNetwork
     int m_buffers_per_data_vc;
     int m_buffers_per_ctrl_vc;
 
+    FlitAllocator<flit_d> m_flit_allocator;
+
     // Statistical variables for power
     Stats::Scalar m_dynamic_link_power;
     Stats::Scalar m_static_link_power;
@@ -118,6 +125,10 @@ class GarnetNetwork_d : public BaseGarnetNetwork
     // Statistical variables for performance
     Stats::Scalar m_average_link_utilization;
     Stats::Vector m_average_vc_load;
+
+    Stats::Scalar m_router_evaluations;
+    Stats::Scalar m_router_flits;
+    Stats::Formula m_evaluations_per_flit;
 };
 
 inline std::ostream&
@@ -28,7 +28,10 @@
  * Authors: Niket Agarwal
  */
 
+#include <algorithm>
+
 #include "base/stl_helpers.hh"
+#include "mem/ruby/network/garnet/fixed-pipeline/GarnetNetwork_d.hh"
 #include "mem/ruby/network/garnet/fixed-pipeline/InputUnit_d.hh"
 #include "mem/ruby/network/garnet/fixed-pipeline/Router_d.hh"
 
@@ -50,11 +53,17 @@ InputUnit_d::InputUnit_d(int id, Router_d *router) : Consumer(router)
     }
 
     creditQueue = new flitBuffer_d();
-    // Instantiating the virtual channels
+    // Instantiating the virtual channels. Whether a vnet carries data is
+    // only known once the controllers are connected, so size them all
+    // for the deeper kind.
+    GarnetNetwork_d *net_ptr = m_router->get_net_ptr();
+    int depth = max(net_ptr->getBuffersPerDataVC(),
+                    net_ptr->getBuffersPerCtrlVC());
     m_vcs.resize(m_num_vcs);
     for (int i=0; i < m_num_vcs; i++) {
-        m_vcs[i] = new VirtualChannel_d(i);
+        m_vcs[i] = new VirtualChannel_d(i, depth);
     }
+    m_active_vcs.resize(m_num_vcs);
 }
 
 InputUnit_d::~InputUnit_d()
@@ -66,6 +75,8 @@ InputUnit_d::~InputUnit_d()
 void
 InputUnit_d::wakeup()
 {
+    m_router->count_evaluation();
+
     flit_d *t_flit;
     if (m_in_link->isReady(m_router->curCycle())) {
 
@@ -95,6 +106,30 @@ InputUnit_d::wakeup()
     }
 }
 
+void
+InputUnit_d::increment_credit(int in_vc, bool free_signal, Cycles curTime)
+{
+    flit_d *t_flit = m_router->get_net_ptr()->getFlitAllocator().create(
+        in_vc, free_signal, curTime);
+    creditQueue->insert(t_flit);
+    m_credit_link->scheduleEventAbsolute(m_router->clockEdge(Cycles(1)));
+}
+
+void
+InputUnit_d::set_vc_active(int vc, bool active)
+{
+    if (active == m_active_vcs.test(vc))
+        return;
+
+    if (active)
+        m_active_vcs.set(vc);
+    else
+        m_active_vcs.clear(vc);
+
+    // let the router know when this port starts or stops having work
+    m_router->set_inport_active(m_id, !m_active_vcs.empty());
+}
+
 uint32_t
 InputUnit_d::functionalWrite(Packet *pkt)
 {
@@ -35,6 +35,7 @@
 #include <vector>
 
 #include "mem/ruby/common/Consumer.hh"
+#include "mem/ruby/network/garnet/fixed-pipeline/ActivityMask_d.hh"
 #include "mem/ruby/network/garnet/fixed-pipeline/CreditLink_d.hh"
 #include "mem/ruby/network/garnet/fixed-pipeline/NetworkLink_d.hh"
 #include "mem/ruby/network/garnet/fixed-pipeline/VirtualChannel_d.hh"
@@ -59,6 +60,7 @@ class InputUnit_d : public Consumer
     set_vc_state(VC_state_type state, int vc, Cycles curTime)
     {
         m_vcs[vc]->set_state(state, curTime);
+        set_vc_active(vc, state != IDLE_);
     }
 
     inline void
@@ -85,13 +87,7 @@ class InputUnit_d : public Consumer
         return m_vcs[vc]->has_credits();
     }
 
-    inline void
-    increment_credit(int in_vc, bool free_signal, Cycles curTime)
-    {
-        flit_d *t_flit = new flit_d(in_vc, free_signal, curTime);
-        creditQueue->insert(t_flit);
-        m_credit_link->scheduleEventAbsolute(m_router->clockEdge(Cycles(1)));
-    }
+    void increment_credit(int in_vc, bool free_signal, Cycles curTime);
 
     inline int
     get_outvc(int invc)
@@ -104,8 +100,12 @@ class InputUnit_d : public Consumer
     {
         m_vcs[vc]->set_outport(outport);
         m_vcs[vc]->set_state(VC_AB_, curTime);
+        set_vc_active(vc, true);
     }
 
+    // The VCs holding a packet, i.e. the ones not in the IDLE_ state
+    const ActivityMask_d& get_active_vcs() const { return m_active_vcs; }
+
     inline void
     grant_vc(int in_vc, int out_vc, Cycles curTime)
     {
@@ -162,6 +162,8 @@ class InputUnit_d : public Consumer
     uint32_t functionalWrite(Packet *pkt);
 
   private:
+    void set_vc_active(int vc, bool active);
+
     int m_id;
     int m_num_vcs;
     int m_vc_per_vnet;
@@ -173,6 +175,7 @@ class InputUnit_d : public Consumer
 
     // Virtual channels
     std::vector<VirtualChannel_d *> m_vcs;
+    ActivityMask_d m_active_vcs;
 
     // Statistical variables
     std::vector<double> m_num_buffer_writes;
@@ -176,8 +176,8 @@ NetworkInterface_d::flitisizeMessage(MsgPtr msg_ptr, int vnet)
 
         for (int i = 0; i < num_flits; i++) {
             m_net_ptr->increment_injected_flits(vnet);
-            flit_d *fl = new flit_d(i, vc, vnet, num_flits, new_msg_ptr,
-                curCycle());
+            flit_d *fl = m_net_ptr->getFlitAllocator().create(i, vc, vnet,
+                num_flits, new_msg_ptr, curCycle());
 
             fl->set_delay(curCycle() - ticksToCycles(msg_ptr->getTime()));
             m_ni_buffers[vc]->insert(fl);
@@ -258,8 +258,8 @@ NetworkInterface_d::wakeup()
         }
         // Simply send a credit back since we are not buffering
         // this flit in the NI
-        flit_d *credit_flit = new flit_d(t_flit->get_vc(), free_signal,
-                                         curCycle());
+        flit_d *credit_flit = m_net_ptr->getFlitAllocator().create(
+            t_flit->get_vc(), free_signal, curCycle());
         creditQueue->insert(credit_flit);
         m_ni_credit_link->
             scheduleEventAbsolute(clockEdge(Cycles(1)));
@@ -271,7 +271,7 @@ NetworkInterface_d::wakeup()
 
         m_net_ptr->increment_network_latency(network_delay, vnet);
         m_net_ptr->increment_queueing_latency(queueing_delay, vnet);
-        delete t_flit;
+        m_net_ptr->getFlitAllocator().destroy(t_flit);
     }
 
     /****************** Checking for credit link *******/
@@ -282,7 +282,7 @@ NetworkInterface_d::wakeup()
         if (t_flit->is_free_signal()) {
             m_out_vc_state[t_flit->get_vc()]->setState(IDLE_, curCycle());
         }
-        delete t_flit;
+        m_net_ptr->getFlitAllocator().destroy(t_flit);
     }
 }
 
@@ -29,6 +29,7 @@
  */
 
 #include "base/stl_helpers.hh"
+#include "mem/ruby/network/garnet/fixed-pipeline/GarnetNetwork_d.hh"
 #include "mem/ruby/network/garnet/fixed-pipeline/OutputUnit_d.hh"
 #include "mem/ruby/network/garnet/fixed-pipeline/Router_d.hh"
 
@@ -77,7 +78,7 @@ OutputUnit_d::wakeup()
         if (t_flit->is_free_signal())
             set_vc_state(IDLE_, out_vc, m_router->curCycle());
 
-        delete t_flit;
+        m_router->get_net_ptr()->getFlitAllocator().destroy(t_flit);
     }
 }
 
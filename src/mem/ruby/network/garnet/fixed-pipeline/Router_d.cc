@@ -58,6 +58,7 @@ Router_d::Router_d(const Params *p)
     m_input_unit.clear();
     m_output_unit.clear();
 
+    m_evaluations = 0;
     crossbar_count = 0;
     sw_local_arbit_count = 0;
     sw_global_arbit_count = 0;
@@ -88,6 +89,7 @@ Router_d::init()
 {
     BasicRouter::init();
 
+    m_active_inports.resize(m_input_unit.size());
     m_vc_alloc->init();
     m_sw_alloc->init();
     m_switch->init();
@@ -150,6 +152,21 @@ Router_d::update_incredit(int in_port, int in_vc, int credit)
     m_input_unit[in_port]->update_credit(in_vc, credit);
 }
 
+void
+Router_d::set_inport_active(int inport, bool active)
+{
+    if (active)
+        m_active_inports.set(inport);
+    else
+        m_active_inports.clear(inport);
+}
+
+double
+Router_d::get_flit_count() const
+{
+    return m_switch->get_crossbar_count();
+}
+
 void
 Router_d::update_sw_winner(int inport, flit_d *t_flit)
 {
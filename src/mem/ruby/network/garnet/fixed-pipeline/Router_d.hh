@@ -36,6 +36,7 @@
 
 #include "mem/ruby/common/NetDest.hh"
 #include "mem/ruby/network/BasicRouter.hh"
+#include "mem/ruby/network/garnet/fixed-pipeline/ActivityMask_d.hh"
 #include "mem/ruby/network/garnet/fixed-pipeline/flit_d.hh"
 #include "mem/ruby/network/garnet/NetworkHeader.hh"
 #include "mem/ruby/network/orion/NetworkPower.hh"
@@ -81,6 +82,16 @@ class Router_d : public BasicRouter
     std::vector<InputUnit_d *>& get_inputUnit_ref()   { return m_input_unit; }
     std::vector<OutputUnit_d *>& get_outputUnit_ref() { return m_output_unit; }
 
+    // The input ports with at least one VC holding a packet
+    const ActivityMask_d& get_active_inports() const
+    { return m_active_inports; }
+    void set_inport_active(int inport, bool active);
+
+    // Evaluations of the pipeline stages, for the activity stats
+    void count_evaluation() { m_evaluations++; }
+    double get_evaluation_count() const { return m_evaluations; }
+    double get_flit_count() const;
+
     void update_sw_winner(int inport, flit_d *t_flit);
     void update_incredit(int in_port, int in_vc, int credit);
     void route_req(flit_d *t_flit, InputUnit_d* in_unit, int invc);
@@ -119,6 +130,8 @@ class Router_d : public BasicRouter
     VCallocator_d *m_vc_alloc;
     SWallocator_d *m_sw_alloc;
     Switch_d *m_switch;
+    ActivityMask_d m_active_inports;
+    double m_evaluations;
 
     // Statistical variables for power
     double m_power_dyn;
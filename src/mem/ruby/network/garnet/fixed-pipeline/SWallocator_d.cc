@@ -53,30 +53,23 @@ SWallocator_d::init()
 
     m_num_inports = m_router->get_num_inports();
     m_num_outports = m_router->get_num_outports();
-    m_round_robin_outport.resize(m_num_outports);
-    m_round_robin_inport.resize(m_num_inports);
+    m_round_robin_outport = 0;
+    m_round_robin_inport = 0;
     m_port_req.resize(m_num_outports);
+    m_requested_outports.resize(m_num_outports);
     m_vc_winners.resize(m_num_outports);
 
-    for (int i = 0; i < m_num_inports; i++) {
-        m_round_robin_inport[i] = 0;
-    }
-
     for (int i = 0; i < m_num_outports; i++) {
-        m_port_req[i].resize(m_num_inports);
+        m_port_req[i].resize(m_num_inports); // [outport][inport]
         m_vc_winners[i].resize(m_num_inports);
-
-        m_round_robin_outport[i] = 0;
-
-        for (int j = 0; j < m_num_inports; j++) {
-            m_port_req[i][j] = false; // [outport][inport]
-        }
     }
 }
 
 void
 SWallocator_d::wakeup()
 {
+    m_router->count_evaluation();
+
     arbitrate_inports(); // First stage of allocation
     arbitrate_outports(); // Second stage of allocation
 
@@ -88,44 +81,47 @@ SWallocator_d::wakeup()
 void
 SWallocator_d::arbitrate_inports()
 {
-    // First do round robin arbitration on a set of input vc requests
-    for (int inport = 0; inport < m_num_inports; inport++) {
-        int invc = m_round_robin_inport[inport];
+    int invc = m_round_robin_inport;
 
-        // Select next round robin vc candidate within valid vnet
-        int next_round_robin_invc = invc;
-        do {
-            next_round_robin_invc++;
+    // Select next round robin vc candidate within valid vnet
+    int next_round_robin_invc = invc;
+    do {
+        next_round_robin_invc++;
 
-            if (next_round_robin_invc >= m_num_vcs)
-                next_round_robin_invc = 0;
-        } while (!((m_router->get_net_ptr())->validVirtualNetwork(
-                    get_vnet(next_round_robin_invc))));
+        if (next_round_robin_invc >= m_num_vcs)
+            next_round_robin_invc = 0;
+    } while (!((m_router->get_net_ptr())->validVirtualNetwork(
+                get_vnet(next_round_robin_invc))));
 
-        m_round_robin_inport[inport] = next_round_robin_invc;
+    m_round_robin_inport = next_round_robin_invc;
 
-        for (int invc_iter = 0; invc_iter < m_num_vcs; invc_iter++) {
-            invc++;
-            if (invc >= m_num_vcs)
-                invc = 0;
+    // Only the vcs holding a packet can need switch allocation. Do round
+    // robin arbitration on them, starting after the pointer.
+    int first_invc = (invc + 1 < m_num_vcs) ? invc + 1 : 0;
+    const ActivityMask_d& active_inports = m_router->get_active_inports();
 
-            if (!((m_router->get_net_ptr())->validVirtualNetwork(
-                get_vnet(invc))))
-                continue;
+    for (int inport = active_inports.next(0); inport < m_num_inports;
+         inport = active_inports.next(inport + 1)) {
+        const ActivityMask_d& active_vcs =
+            m_input_unit[inport]->get_active_vcs();
+        int start = active_vcs.nextCyclic(first_invc);
+        int vc = start;
 
-            if (m_input_unit[inport]->need_stage(invc, ACTIVE_, SA_,
-                                                 m_router->curCycle()) &&
-                m_input_unit[inport]->has_credits(invc)) {
-
-                if (is_candidate_inport(inport, invc)) {
-                    int outport = m_input_unit[inport]->get_route(invc);
-                    m_local_arbiter_activity++;
-                    m_port_req[outport][inport] = true;
-                    m_vc_winners[outport][inport]= invc;
-                    break; // got one vc winner for this port
-                }
+        do {
+            if ((m_router->get_net_ptr())->validVirtualNetwork(get_vnet(vc))
+                && m_input_unit[inport]->need_stage(vc, ACTIVE_, SA_,
+                                                    m_router->curCycle())
+                && m_input_unit[inport]->has_credits(vc)
+                && is_candidate_inport(inport, vc)) {
+                int outport = m_input_unit[inport]->get_route(vc);
+                m_local_arbiter_activity++;
+                m_port_req[outport].set(inport);
+                m_requested_outports.set(outport);
+                m_vc_winners[outport][inport] = vc;
+                break; // got one vc winner for this port
             }
-        }
+            vc = active_vcs.nextCyclic(vc + 1);
+        } while (vc != start);
     }
 }
 
@@ -158,59 +154,58 @@ SWallocator_d::arbitrate_outports()
 {
     // Now there are a set of input vc requests for output vcs.
     // Again do round robin arbitration on these requests
-    for (int outport = 0; outport < m_num_outports; outport++) {
-        int inport = m_round_robin_outport[outport];
-        m_round_robin_outport[outport]++;
-
-        if (m_round_robin_outport[outport] >= m_num_outports)
-            m_round_robin_outport[outport] = 0;
-
-        for (int inport_iter = 0; inport_iter < m_num_inports; inport_iter++) {
-            inport++;
-            if (inport >= m_num_inports)
-                inport = 0;
-
-            // inport has a request this cycle for outport:
-            if (m_port_req[outport][inport]) {
-                m_port_req[outport][inport] = false;
-                int invc = m_vc_winners[outport][inport];
-                int outvc = m_input_unit[inport]->get_outvc(invc);
-
-                // remove flit from Input Unit
-                flit_d *t_flit = m_input_unit[inport]->getTopFlit(invc);
-                t_flit->advance_stage(ST_, m_router->curCycle());
-                t_flit->set_vc(outvc);
-                t_flit->set_outport(outport);
-                t_flit->set_time(m_router->curCycle() + Cycles(1));
-
-                m_output_unit[outport]->decrement_credit(outvc);
-                m_router->update_sw_winner(inport, t_flit);
-                m_global_arbiter_activity++;
-
-                if ((t_flit->get_type() == TAIL_) ||
-                    t_flit->get_type() == HEAD_TAIL_) {
-
-                    // Send a credit back
-                    // along with the information that this VC is now idle
-                    m_input_unit[inport]->increment_credit(invc, true,
-                        m_router->curCycle());
-
-                    // This Input VC should now be empty
-                    assert(m_input_unit[inport]->isReady(invc,
-                        m_router->curCycle()) == false);
-
-                    m_input_unit[inport]->set_vc_state(IDLE_, invc,
-                        m_router->curCycle());
-                    m_input_unit[inport]->set_enqueue_time(invc,
-                        Cycles(INFINITE_));
-                } else {
-                    // Send a credit back
-                    // but do not indicate that the VC is idle
-                    m_input_unit[inport]->increment_credit(invc, false,
-                        m_router->curCycle());
-                }
-                break; // got a in request for this outport
-            }
+    int inport_pointer = m_round_robin_outport;
+    m_round_robin_outport++;
+
+    if (m_round_robin_outport >= m_num_outports)
+        m_round_robin_outport = 0;
+
+    // the round robin starts after the pointer, or at the first inport
+    // when the pointer is past the last one
+    int first_inport = inport_pointer + 1;
+    if (first_inport >= m_num_inports)
+        first_inport = 0;
+
+    for (int outport = m_requested_outports.next(0);
+         outport < m_num_outports;
+         outport = m_requested_outports.next(outport + 1)) {
+        // inport has a request this cycle for outport:
+        int inport = m_port_req[outport].nextCyclic(first_inport);
+        int invc = m_vc_winners[outport][inport];
+        int outvc = m_input_unit[inport]->get_outvc(invc);
+
+        // remove flit from Input Unit
+        flit_d *t_flit = m_input_unit[inport]->getTopFlit(invc);
+        t_flit->advance_stage(ST_, m_router->curCycle());
+        t_flit->set_vc(outvc);
+        t_flit->set_outport(outport);
+        t_flit->set_time(m_router->curCycle() + Cycles(1));
+
+        m_output_unit[outport]->decrement_credit(outvc);
+        m_router->update_sw_winner(inport, t_flit);
+        m_global_arbiter_activity++;
+
+        if ((t_flit->get_type() == TAIL_) ||
+            t_flit->get_type() == HEAD_TAIL_) {
+
+            // Send a credit back
+            // along with the information that this VC is now idle
+            m_input_unit[inport]->increment_credit(invc, true,
+                m_router->curCycle());
+
+            // This Input VC should now be empty
+            assert(m_input_unit[inport]->isReady(invc,
+                m_router->curCycle()) == false);
+
+            m_input_unit[inport]->set_vc_state(IDLE_, invc,
+                m_router->curCycle());
+            m_input_unit[inport]->set_enqueue_time(invc,
+                Cycles(INFINITE_));
+        } else {
+            // Send a credit back
+            // but do not indicate that the VC is idle
+            m_input_unit[inport]->increment_credit(invc, false,
+                m_router->curCycle());
         }
     }
 }
@@ -219,9 +214,13 @@ void
 SWallocator_d::check_for_wakeup()
 {
     Cycles nextCycle = m_router->curCycle() + Cycles(1);
+    const ActivityMask_d& active_inports = m_router->get_active_inports();
 
-    for (int i = 0; i < m_num_inports; i++) {
-        for (int j = 0; j < m_num_vcs; j++) {
+    for (int i = active_inports.next(0); i < m_num_inports;
+         i = active_inports.next(i + 1)) {
+        const ActivityMask_d& active_vcs = m_input_unit[i]->get_active_vcs();
+        for (int j = active_vcs.next(0); j < m_num_vcs;
+             j = active_vcs.next(j + 1)) {
             if (m_input_unit[i]->need_stage(j, ACTIVE_, SA_, nextCycle)) {
                 scheduleEvent(Cycles(1));
                 return;
@@ -241,9 +240,9 @@ SWallocator_d::get_vnet(int invc)
 void
 SWallocator_d::clear_request_vector()
 {
-    for (int i = 0; i < m_num_outports; i++) {
-        for (int j = 0; j < m_num_inports; j++) {
-            m_port_req[i][j] = false;
-        }
+    for (int i = m_requested_outports.next(0); i < m_num_outports;
+         i = m_requested_outports.next(i + 1)) {
+        m_port_req[i].clear();
     }
+    m_requested_outports.clear();
 }
@@ -35,6 +35,7 @@
 #include <vector>
 
 #include "mem/ruby/common/Consumer.hh"
+#include "mem/ruby/network/garnet/fixed-pipeline/ActivityMask_d.hh"
 #include "mem/ruby/network/garnet/NetworkHeader.hh"
 
 class Router_d;
@@ -73,9 +74,13 @@ class SWallocator_d : public Consumer
     double m_local_arbiter_activity, m_global_arbiter_activity;
 
     Router_d *m_router;
-    std::vector<int> m_round_robin_outport;
-    std::vector<int> m_round_robin_inport;
-    std::vector<std::vector<bool> > m_port_req;
+    // every port advances its round robin pointer on every wakeup, so
+    // they all hold the same value and one of each kind is kept
+    int m_round_robin_outport;
+    int m_round_robin_inport;
+    // inports requesting each outport, and the outports requested
+    std::vector<ActivityMask_d> m_port_req;
+    ActivityMask_d m_requested_outports;
     std::vector<std::vector<int> > m_vc_winners; // a list for each outport
     std::vector<InputUnit_d *> m_input_unit;
     std::vector<OutputUnit_d *> m_output_unit;
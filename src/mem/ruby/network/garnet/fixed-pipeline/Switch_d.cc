@@ -66,6 +66,7 @@ Switch_d::wakeup()
 {
     DPRINTF(RubyNetwork, "Switch woke up at time: %lld\n",
             m_router->curCycle());
+    m_router->count_evaluation();
 
     for (int inport = 0; inport < m_num_inports; inport++) {
         if (!m_switch_buffer[inport]->isReady(m_router->curCycle()))
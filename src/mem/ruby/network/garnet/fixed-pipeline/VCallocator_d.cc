@@ -61,6 +61,7 @@ VCallocator_d::init()
     m_round_robin_outvc.resize(m_num_outports);
     m_outvc_req.resize(m_num_outports);
     m_outvc_is_req.resize(m_num_outports);
+    m_requested_outports.resize(m_num_outports);
 
     for (int i = 0; i < m_num_inports; i++) {
         m_round_robin_invc[i].resize(m_num_vcs);
@@ -78,7 +79,6 @@ VCallocator_d::init()
         for (int j = 0; j < m_num_vcs; j++) {
             m_round_robin_outvc[i][j].first = 0;
             m_round_robin_outvc[i][j].second = 0;
-            m_outvc_is_req[i][j] = false;
 
             m_outvc_req[i][j].resize(m_num_inports);
 
@@ -95,23 +95,26 @@ VCallocator_d::init()
 void
 VCallocator_d::clear_request_vector()
 {
-    for (int i = 0; i < m_num_outports; i++) {
-        for (int j = 0; j < m_num_vcs; j++) {
-            if (!m_outvc_is_req[i][j])
-                continue;
-            m_outvc_is_req[i][j] = false;
+    for (int i = m_requested_outports.next(0); i < m_num_outports;
+         i = m_requested_outports.next(i + 1)) {
+        for (int j = m_outvc_is_req[i].next(0); j < m_num_vcs;
+             j = m_outvc_is_req[i].next(j + 1)) {
             for (int k = 0; k < m_num_inports; k++) {
                 for (int l = 0; l < m_num_vcs; l++) {
                     m_outvc_req[i][j][k][l] = false;
                 }
             }
         }
+        m_outvc_is_req[i].clear();
     }
+    m_requested_outports.clear();
 }
 
 void
 VCallocator_d::wakeup()
 {
+    m_router->count_evaluation();
+
     arbitrate_invcs(); // First stage of allocation
     arbitrate_outvcs(); // Second stage of allocation
 
@@ -167,8 +170,8 @@ VCallocator_d::select_outvc(int inport_iter, int invc_iter)
         if (m_output_unit[outport]->is_vc_idle(outvc, m_router->curCycle())) {
             m_local_arbiter_activity[vnet]++;
             m_outvc_req[outport][outvc][inport_iter][invc_iter] = true;
-            if (!m_outvc_is_req[outport][outvc])
-                m_outvc_is_req[outport][outvc] = true;
+            m_outvc_is_req[outport].set(outvc);
+            m_requested_outports.set(outport);
             return; // out vc acquired
         }
     }
@@ -177,8 +180,17 @@ VCallocator_d::select_outvc(int inport_iter, int invc_iter)
 void
 VCallocator_d::arbitrate_invcs()
 {
-    for (int inport_iter = 0; inport_iter < m_num_inports; inport_iter++) {
-        for (int invc_iter = 0; invc_iter < m_num_vcs; invc_iter++) {
+    // only the vcs holding a packet can need vc allocation
+    const ActivityMask_d& active_inports = m_router->get_active_inports();
+
+    for (int inport_iter = active_inports.next(0);
+         inport_iter < m_num_inports;
+         inport_iter = active_inports.next(inport_iter + 1)) {
+        const ActivityMask_d& active_vcs =
+            m_input_unit[inport_iter]->get_active_vcs();
+
+        for (int invc_iter = active_vcs.next(0); invc_iter < m_num_vcs;
+             invc_iter = active_vcs.next(invc_iter + 1)) {
             if (!((m_router->get_net_ptr())->validVirtualNetwork(
                 get_vnet(invc_iter))))
                 continue;
@@ -197,13 +209,14 @@ VCallocator_d::arbitrate_invcs()
 void
 VCallocator_d::arbitrate_outvcs()
 {
-    for (int outport_iter = 0; outport_iter < m_num_outports; outport_iter++) {
-        for (int outvc_iter = 0; outvc_iter < m_num_vcs; outvc_iter++) {
-            if (!m_outvc_is_req[outport_iter][outvc_iter]) {
-                // No requests for this outvc in this cycle
-                continue;
-            }
+    for (int outport_iter = m_requested_outports.next(0);
+         outport_iter < m_num_outports;
+         outport_iter = m_requested_outports.next(outport_iter + 1)) {
+        const ActivityMask_d& requested_outvcs = m_outvc_is_req[outport_iter];
 
+        for (int outvc_iter = requested_outvcs.next(0);
+             outvc_iter < m_num_vcs;
+             outvc_iter = requested_outvcs.next(outvc_iter + 1)) {
             int inport = m_round_robin_outvc[outport_iter][outvc_iter].first;
             int invc_offset =
                 m_round_robin_outvc[outport_iter][outvc_iter].second;
@@ -257,9 +270,13 @@ void
 VCallocator_d::check_for_wakeup()
 {
     Cycles nextCycle = m_router->curCycle() + Cycles(1);
+    const ActivityMask_d& active_inports = m_router->get_active_inports();
 
-    for (int i = 0; i < m_num_inports; i++) {
-        for (int j = 0; j < m_num_vcs; j++) {
+    for (int i = active_inports.next(0); i < m_num_inports;
+         i = active_inports.next(i + 1)) {
+        const ActivityMask_d& active_vcs = m_input_unit[i]->get_active_vcs();
+        for (int j = active_vcs.next(0); j < m_num_vcs;
+             j = active_vcs.next(j + 1)) {
             if (m_input_unit[i]->need_stage(j, VC_AB_, VA_, nextCycle)) {
                 scheduleEvent(Cycles(1));
                 return;
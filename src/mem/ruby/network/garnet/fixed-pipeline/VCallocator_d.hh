@@ -36,6 +36,7 @@
 #include <vector>
 
 #include "mem/ruby/common/Consumer.hh"
+#include "mem/ruby/network/garnet/fixed-pipeline/ActivityMask_d.hh"
 #include "mem/ruby/network/garnet/NetworkHeader.hh"
 
 class Router_d;
@@ -81,7 +82,9 @@ class VCallocator_d : public Consumer
     // set true in the first phase of allocation
     std::vector<std::vector<std::vector<std::vector<bool> > > > m_outvc_req;
 
-    std::vector<std::vector<bool> > m_outvc_is_req;
+    // requested outvcs of each outport, and the outports requested
+    std::vector<ActivityMask_d> m_outvc_is_req;
+    ActivityMask_d m_requested_outports;
 
     std::vector<InputUnit_d *> m_input_unit;
     std::vector<OutputUnit_d *> m_output_unit;
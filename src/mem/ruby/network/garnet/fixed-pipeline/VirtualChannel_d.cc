@@ -30,11 +30,13 @@
 
 #include "mem/ruby/network/garnet/fixed-pipeline/VirtualChannel_d.hh"
 
-VirtualChannel_d::VirtualChannel_d(int id)
+VirtualChannel_d::VirtualChannel_d(int id, int depth)
     : m_enqueue_time(INFINITE_)
 {
     m_id = id;
     m_input_buffer = new flitBuffer_d();
+    // credits keep the upstream router from sending more than this
+    m_input_buffer->reserve(depth);
     m_vc_state.first = IDLE_;
     m_vc_state.second = Cycles(0);
 }
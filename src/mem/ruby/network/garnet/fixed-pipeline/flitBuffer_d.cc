@@ -32,24 +32,28 @@
 
 flitBuffer_d::flitBuffer_d()
 {
+    m_head = 0;
+    m_size = 0;
     max_size = INFINITE_;
 }
 
 flitBuffer_d::flitBuffer_d(int maximum_size)
 {
+    m_head = 0;
+    m_size = 0;
     max_size = maximum_size;
 }
 
 bool
 flitBuffer_d::isEmpty()
 {
-    return (m_buffer.size() == 0);
+    return (m_size == 0);
 }
 
 bool
 flitBuffer_d::isReady(Cycles curTime)
 {
-    if (m_buffer.size() != 0 ) {
+    if (m_size != 0 ) {
         flit_d *t_flit = peekTopFlit();
         if (t_flit->get_time() <= curTime)
             return true;
@@ -60,13 +64,13 @@ flitBuffer_d::isReady(Cycles curTime)
 void
 flitBuffer_d::print(std::ostream& out) const
 {
-    out << "[flitBuffer: " << m_buffer.size() << "] " << std::endl;
+    out << "[flitBuffer: " << m_size << "] " << std::endl;
 }
 
 bool
 flitBuffer_d::isFull()
 {
-    return (m_buffer.size() >= max_size);
+    return (m_size >= max_size);
 }
 
 void
@@ -75,13 +79,32 @@ flitBuffer_d::setMaxSize(int maximum)
     max_size = maximum;
 }
 
+void
+flitBuffer_d::reserve(int capacity)
+{
+    if (capacity <= m_buffer.size())
+        return;
+
+    int new_size = 4;
+    while (new_size < capacity)
+        new_size *= 2;
+
+    // unwrap the flits to the front of the new storage
+    std::vector<flit_d *> buffer(new_size);
+    for (int i = 0; i < m_size; i++)
+        buffer[i] = slot(i);
+
+    m_buffer.swap(buffer);
+    m_head = 0;
+}
+
 uint32_t
 flitBuffer_d::functionalWrite(Packet *pkt)
 {
     uint32_t num_functional_writes = 0;
 
-    for (unsigned int i = 0; i < m_buffer.size(); ++i) {
-        if (m_buffer[i]->functionalWrite(pkt)) {
+    for (int i = 0; i < m_size; ++i) {
+        if (slot(i)->functionalWrite(pkt)) {
             num_functional_writes++;
         }
     }
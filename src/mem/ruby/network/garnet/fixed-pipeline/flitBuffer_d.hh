@@ -31,13 +31,18 @@
 #ifndef __MEM_RUBY_NETWORK_GARNET_FIXED_PIPELINE_FLIT_BUFFER_D_HH__
 #define __MEM_RUBY_NETWORK_GARNET_FIXED_PIPELINE_FLIT_BUFFER_D_HH__
 
-#include <algorithm>
 #include <iostream>
 #include <vector>
 
 #include "mem/ruby/network/garnet/fixed-pipeline/flit_d.hh"
 #include "mem/ruby/network/garnet/NetworkHeader.hh"
 
+/*
+ * Flits leave in the order of flit_d::greater, i.e. by time and then by
+ * id. Nearly all buffers receive them in that order already, so they are
+ * kept in a circular buffer: insertion appends at the back and only walks
+ * backwards past the flits that must leave after a late one.
+ */
 class flitBuffer_d
 {
   public:
@@ -49,33 +54,53 @@ class flitBuffer_d
     void print(std::ostream& out) const;
     bool isFull();
     void setMaxSize(int maximum);
+    // make room for this many flits up front
+    void reserve(int capacity);
 
     flit_d *
     getTopFlit()
     {
-        flit_d *f = m_buffer.front();
-        std::pop_heap(m_buffer.begin(), m_buffer.end(), flit_d::greater);
-        m_buffer.pop_back();
+        flit_d *f = m_buffer[m_head];
+        m_head = (m_head + 1) & (m_buffer.size() - 1);
+        m_size--;
         return f;
     }
 
     flit_d *
     peekTopFlit()
     {
-        return m_buffer.front();
+        return m_buffer[m_head];
     }
 
     void
     insert(flit_d *flt)
     {
-        m_buffer.push_back(flt);
-        std::push_heap(m_buffer.begin(), m_buffer.end(), flit_d::greater);
+        if (m_size == m_buffer.size())
+            reserve(m_size + 1);
+
+        int pos = m_size;
+        while (pos > 0 && flit_d::greater(slot(pos - 1), flt)) {
+            slot(pos) = slot(pos - 1);
+            pos--;
+        }
+        slot(pos) = flt;
+        m_size++;
     }
 
     uint32_t functionalWrite(Packet *pkt);
 
   private:
+    // the i-th flit from the top
+    flit_d *&
+    slot(int i)
+    {
+        return m_buffer[(m_head + i) & (m_buffer.size() - 1)];
+    }
+
+    // ring storage, its size is zero or a power of two
     std::vector<flit_d *> m_buffer;
+    int m_head;
+    int m_size;
     int max_size;
 };
 
@@ -237,6 +237,10 @@ GarnetNetwork::collateStats()
             m_average_vc_load[j] += vc_load[j];
         }
     }
+
+    m_flit_allocations = m_flit_allocator.get_allocation_count();
+    m_flit_slabs = m_flit_allocator.get_slab_count();
+    m_peak_flits_in_use = m_flit_allocator.get_peak_in_use();
 }
 
 void
@@ -35,6 +35,8 @@
 #include <vector>
 
 #include "mem/ruby/network/garnet/BaseGarnetNetwork.hh"
+#include "mem/ruby/network/garnet/flexible-pipeline/flit.hh"
+#include "mem/ruby/network/garnet/FlitAllocator.hh"
 #include "mem/ruby/network/garnet/NetworkHeader.hh"
 #include "params/GarnetNetwork.hh"
 
@@ -54,6 +56,7 @@ class GarnetNetwork : public BaseGarnetNetwork
 
     int getBufferSize() { return m_buffer_size; }
     int getNumPipeStages() {return m_number_of_pipe_stages; }
+    FlitAllocator<flit>& getFlitAllocator() { return m_flit_allocator; }
 
     void collateStats();
     void regStats();
@@ -92,6 +95,8 @@ class GarnetNetwork : public BaseGarnetNetwork
     int m_buffer_size;
     int m_number_of_pipe_stages;
 
+    FlitAllocator<flit> m_flit_allocator;
+
     // Statistical variables
     Stats::Scalar m_average_link_utilization;
     Stats::Vector m_average_vc_load;
@@ -167,8 +167,8 @@ NetworkInterface::flitisizeMessage(MsgPtr msg_ptr, int vnet)
         }
         for (int i = 0; i < num_flits; i++) {
             m_net_ptr->increment_injected_flits(vnet);
-            flit *fl = new flit(i, vc, vnet, num_flits, new_msg_ptr,
-                                curCycle());
+            flit *fl = m_net_ptr->getFlitAllocator().create(i, vc, vnet,
+                num_flits, new_msg_ptr, curCycle());
             fl->set_delay(curCycle() - ticksToCycles(msg_ptr->getTime()));
             m_ni_buffers[vc]->insert(fl);
         }
@@ -287,7 +287,7 @@ NetworkInterface::wakeup()
 
         m_net_ptr->increment_network_latency(network_delay, vnet);
         m_net_ptr->increment_queueing_latency(queueing_delay, vnet);
-        delete t_flit;
+        m_net_ptr->getFlitAllocator().destroy(t_flit);
     }
 }
 
@@ -41,13 +41,6 @@ using namespace std;
 
 const int PRIORITY_SWITCH_LIMIT = 128;
 
-// Operator for helper class
-bool
-operator<(const LinkOrder& l1, const LinkOrder& l2)
-{
-    return (l1.m_value < l2.m_value);
-}
-
 PerfectSwitch::PerfectSwitch(SwitchID sid, Switch *sw, uint32_t virt_nets)
     : Consumer(sw)
 {
@@ -93,15 +86,11 @@ void
 PerfectSwitch::addOutPort(const vector<MessageBuffer*>& out,
                           const NetDest& routing_table_entry)
 {
-    // Setup link order
-    LinkOrder l;
-    l.m_value = 0;
-    l.m_link = m_out.size();
-    m_link_order.push_back(l);
+    m_link_value.push_back(0);
 
     // Add to routing table
     m_out.push_back(out);
-    m_routing_table.push_back(routing_table_entry);
+    m_routing_table.addLink(routing_table_entry);
 }
 
 PerfectSwitch::~PerfectSwitch()
@@ -154,65 +143,35 @@ PerfectSwitch::operateVnet(int vnet)
 
                 output_links.clear();
                 output_link_destinations.clear();
-                NetDest msg_dsts = net_msg_ptr->getInternalDestination();
 
                 // Unfortunately, the token-protocol sends some
-                // zero-destination messages, so this assert isn't valid
-                // assert(msg_dsts.count() > 0);
-
-                assert(m_link_order.size() == m_routing_table.size());
-                assert(m_link_order.size() == m_out.size());
-
-                if (m_network_ptr->getAdaptiveRouting()) {
-                    if (m_network_ptr->isVNetOrdered(vnet)) {
-                        // Don't adaptively route
-                        for (int out = 0; out < m_out.size(); out++) {
-                            m_link_order[out].m_link = out;
-                            m_link_order[out].m_value = 0;
+                // zero-destination messages, so no destinations (and no
+                // output links) is valid
+
+                assert(m_routing_table.getLinks() == m_out.size());
+
+                // Look at the most empty link first when routing
+                // adaptively, otherwise in link order
+                const vector<int>* link_value = NULL;
+                if (m_network_ptr->getAdaptiveRouting() &&
+                    !m_network_ptr->isVNetOrdered(vnet)) {
+                    // Find how clogged each link is
+                    for (int out = 0; out < m_out.size(); out++) {
+                        int out_queue_length = 0;
+                        for (int v = 0; v < m_virtual_networks; v++) {
+                            out_queue_length += m_out[out][v]->getSize();
                         }
-                    } else {
-                        // Find how clogged each link is
-                        for (int out = 0; out < m_out.size(); out++) {
-                            int out_queue_length = 0;
-                            for (int v = 0; v < m_virtual_networks; v++) {
-                                out_queue_length += m_out[out][v]->getSize();
-                            }
-                            int value =
-                                (out_queue_length << 8) |
-                                random_mt.random(0, 0xff);
-                            m_link_order[out].m_link = out;
-                            m_link_order[out].m_value = value;
-                        }
-
-                        // Look at the most empty link first
-                        sort(m_link_order.begin(), m_link_order.end());
+                        m_link_value[out] =
+                            (out_queue_length << 8) |
+                            random_mt.random(0, 0xff);
                     }
+                    link_value = &m_link_value;
                 }
 
-                for (int i = 0; i < m_routing_table.size(); i++) {
-                    // pick the next link to look at
-                    int link = m_link_order[i].m_link;
-                    NetDest dst = m_routing_table[link];
-                    DPRINTF(RubyNetwork, "dst: %s\n", dst);
-
-                    if (!msg_dsts.intersectionIsNotEmpty(dst))
-                        continue;
-
-                    // Remember what link we're using
-                    output_links.push_back(link);
-
-                    // Need to remember which destinations need this message in
-                    // another vector.  This Set is the intersection of the
-                    // routing_table entry and the current destination set.  The
-                    // intersection must not be empty, since we are inside "if"
-                    output_link_destinations.push_back(msg_dsts.AND(dst));
-
-                    // Next, we update the msg_destination not to include
-                    // those nodes that were already handled by this link
-                    msg_dsts.removeNetDest(dst);
-                }
-
-                assert(msg_dsts.count() == 0);
+                // Split the destinations among the links that reach them
+                m_routing_table.route(net_msg_ptr->getInternalDestination(),
+                                      link_value, output_links,
+                                      output_link_destinations);
 
                 // Check for resources - for all outgoing queues
                 bool enough = true;
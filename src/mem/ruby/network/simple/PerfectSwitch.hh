@@ -41,20 +41,13 @@
 #include <vector>
 
 #include "mem/ruby/common/Consumer.hh"
+#include "mem/ruby/network/PortRoutingTable.hh"
 
 class MessageBuffer;
 class NetDest;
 class SimpleNetwork;
 class Switch;
 
-struct LinkOrder
-{
-    int m_link;
-    int m_value;
-};
-
-bool operator<(const LinkOrder& l1, const LinkOrder& l2);
-
 class PerfectSwitch : public Consumer
 {
   public:
@@ -92,8 +85,9 @@ class PerfectSwitch : public Consumer
     std::vector<std::vector<MessageBuffer*> > m_in;
     std::vector<std::vector<MessageBuffer*> > m_out;
 
-    std::vector<NetDest> m_routing_table;
-    std::vector<LinkOrder> m_link_order;
+    // output links of each destination, and how clogged each link is
+    PortRoutingTable m_routing_table;
+    std::vector<int> m_link_value;
 
     uint32_t m_virtual_networks;
     int m_round_robin_start;
@@ -49,6 +49,7 @@ SimpleNetwork::SimpleNetwork(const Params *p)
     m_buffer_size = p->buffer_size;
     m_endpoint_bandwidth = p->endpoint_bandwidth;
     m_adaptive_routing = p->adaptive_routing;
+    m_event_driven_throttle = p->event_driven_throttle;
 
     // Note: the parent Network Object constructor is called before the
     // SimpleNetwork child constructor.  Therefore, the member variables
@@ -52,6 +52,7 @@ class SimpleNetwork : public Network
     int getBufferSize() { return m_buffer_size; }
     int getEndpointBandwidth() { return m_endpoint_bandwidth; }
     bool getAdaptiveRouting() {return m_adaptive_routing; }
+    bool getEventDrivenThrottle() { return m_event_driven_throttle; }
 
     void collateStats();
     void regStats();
@@ -99,6 +100,7 @@ class SimpleNetwork : public Network
     int m_buffer_size;
     int m_endpoint_bandwidth;
     bool m_adaptive_routing;    
+    bool m_event_driven_throttle;
 
     //Statistical variables
     Stats::Formula m_msg_counts[MessageSizeType_NUM];
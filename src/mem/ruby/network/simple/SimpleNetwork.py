@@ -39,6 +39,9 @@ class SimpleNetwork(RubyNetwork):
         "default buffer size; 0 indicates infinite buffering");
     endpoint_bandwidth = Param.Int(1000, "bandwidth adjustment factor");
     adaptive_routing = Param.Bool(False, "enable adaptive routing");
+    event_driven_throttle = Param.Bool(False,
+        "throttles sleep until the message on the link is sent instead of "
+        "waking up every cycle");
 
 class Switch(BasicRouter):
     type = 'Switch'
@@ -85,6 +85,7 @@ Switch::addOutPort(const vector<MessageBuffer*>& out,
                                           link_latency, bw_multiplier,
                                           m_network_ptr->getEndpointBandwidth(),
                                           this);
+    throttle_ptr->setEventDriven(m_network_ptr->getEventDrivenThrottle());
 
     m_throttles.push_back(throttle_ptr);
 
@@ -79,6 +79,10 @@ Throttle::init(NodeID node, Cycles link_latency,
 
     m_wakeups_wo_switch = 0;
     m_link_utilization_proxy = 0;
+
+    m_event_driven = false;
+    m_last_wakeup = Cycles(0);
+    m_busy_vnet = -1;
 }
 
 void
@@ -163,6 +167,10 @@ Throttle::wakeup()
     assert(getLinkBandwidth() > 0);
     int bw_remaining = getLinkBandwidth();
 
+    if (m_event_driven) {
+        chargeBusyCycles();
+    }
+
     m_wakeups_wo_switch++;
     bool schedule_wakeup = false;
 
@@ -203,6 +211,13 @@ Throttle::wakeup()
         // available, so we must not have anything else to do until
         // another message arrives.
         DPRINTF(RubyNetwork, "%s not scheduled again\n", *this);
+    } else if (m_event_driven && !schedule_wakeup) {
+        // Out of bandwidth, so sleep until the message holding the link
+        // has been sent
+        Cycles delay = cyclesUntilSent();
+        DPRINTF(RubyNetwork, "%s scheduled again in %d cycles\n", *this,
+                delay);
+        scheduleEvent(delay);
     } else {
         DPRINTF(RubyNetwork, "%s scheduled again\n", *this);
 
@@ -212,6 +227,72 @@ Throttle::wakeup()
     }
 }
 
+/*
+ * Account for the cycles slept through since the last wakeup. In each of
+ * them the per-cycle throttle would have spent the whole bandwidth on the
+ * message of m_busy_vnet and done nothing else.
+ */
+void
+Throttle::chargeBusyCycles()
+{
+    Cycles now = g_system_ptr->curCycle();
+
+    if (m_busy_vnet >= 0 && now > m_last_wakeup + 1) {
+        int busy_cycles = now - m_last_wakeup - 1;
+        int units = busy_cycles * getLinkBandwidth();
+
+        assert(m_units_remaining[m_busy_vnet] > units);
+        m_units_remaining[m_busy_vnet] -= units;
+        m_wakeups_wo_switch += busy_cycles;
+        m_link_utilization_proxy += busy_cycles;
+    }
+
+    m_last_wakeup = now;
+    m_busy_vnet = -1;
+}
+
+/*
+ * Called once the bandwidth of this cycle is spent. Returns the delay to
+ * the cycle in which something other than draining the first busy vnet
+ * happens: that vnet sends the rest of its message and moves on, or the
+ * priorities are inverted. Messages arriving earlier wake the throttle up
+ * on their own.
+ */
+Cycles
+Throttle::cyclesUntilSent()
+{
+    int bw = getLinkBandwidth();
+
+    // the wakeups before the next priority switch go from the last vnet
+    // down to the first one
+    for (int vnet = m_vnets - 1; vnet >= 0; --vnet) {
+        if (m_in[vnet] == nullptr || m_out[vnet] == nullptr) {
+            continue;
+        }
+
+        if (m_units_remaining[vnet] == 0) {
+            if (m_in[vnet]->isReady()) {
+                return Cycles(1);
+            }
+            continue;
+        }
+
+        if (!m_out[vnet]->areNSlotsAvailable(1)) {
+            return Cycles(1);
+        }
+
+        // the message is done in the cycle that spends its last units
+        int cycles = (m_units_remaining[vnet] + bw - 1) / bw;
+        cycles = min(cycles, PRIORITY_SWITCH_LIMIT + 1 - m_wakeups_wo_switch);
+        if (cycles > 1) {
+            m_busy_vnet = vnet;
+        }
+        return Cycles(cycles);
+    }
+
+    return Cycles(1);
+}
+
 void
 Throttle::regStats(string parent)
 {
@@ -66,6 +66,10 @@ class Throttle : public Consumer
                   const std::vector<MessageBuffer*>& out_vec);
     void wakeup();
 
+    // Sleep while a message keeps the link busy rather than waking up
+    // every cycle
+    void setEventDriven(bool event_driven) { m_event_driven = event_driven; }
+
     // The average utilization (a fraction) since last clearStats()
     const Stats::Scalar & getUtilization() const
     { return m_link_utilization; }
@@ -87,6 +91,8 @@ class Throttle : public Consumer
               int endpoint_bandwidth);
     void operateVnet(int vnet, int &bw_remainin, bool &schedule_wakeup,
                      MessageBuffer *in, MessageBuffer *out);
+    void chargeBusyCycles();
+    Cycles cyclesUntilSent();
 
     // Private copy constructor and assignment operator
     Throttle(const Throttle& obj);
@@ -104,6 +110,12 @@ class Throttle : public Consumer
     int m_wakeups_wo_switch;
     int m_endpoint_bandwidth;
 
+    bool m_event_driven;
+    // cycle of the last wakeup, and the vnet whose message holds the link
+    // until the next one (-1 when the throttle wakes up next cycle)
+    Cycles m_last_wakeup;
+    int m_busy_vnet;
+
     // Statistical variables
     Stats::Scalar m_link_utilization;
     Stats::Vector m_msg_counts[MessageSizeType_NUM];
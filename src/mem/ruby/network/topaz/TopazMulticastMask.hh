@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2026 The University of Cantabria (Spain)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Set of destination routers of a multicast TOPAZ message. The first
+ * 64 routers live in an inline word (the one TPZMessage::setMsgmask
+ * understands), so systems up to 64 routers never touch the heap. Any
+ * router above that is kept in extra words allocated on demand.
+ */
+
+#ifndef __MEM_RUBY_NETWORK_TOPAZ_TOPAZMULTICASTMASK_HH__
+#define __MEM_RUBY_NETWORK_TOPAZ_TOPAZMULTICASTMASK_HH__
+
+#include <cassert>
+#include <vector>
+
+#include "base/bitfield.hh"
+#include "mem/ruby/common/TypeDefines.hh"
+
+class TopazMulticastMask
+{
+  public:
+    static const int WORD_BITS = 64;
+    static const int WORD_SHIFT = 6;
+    static const int WORD_MASK = WORD_BITS - 1;
+
+    TopazMulticastMask()
+        : m_size(0), m_first_word(0)
+    {
+    }
+
+    explicit TopazMulticastMask(int size)
+        : m_size(0), m_first_word(0)
+    {
+        setSize(size);
+    }
+
+    void
+    setSize(int size)
+    {
+        m_size = size;
+        int words = (size + WORD_MASK) >> WORD_SHIFT;
+        m_upper_words.assign(words > 1 ? words - 1 : 0, 0);
+        m_first_word = 0;
+    }
+
+    int getSize() const { return m_size; }
+    int getNumWords() const { return m_upper_words.size() + 1; }
+
+    void
+    clear()
+    {
+        m_first_word = 0;
+        for (int i = 0; i < m_upper_words.size(); i++)
+            m_upper_words[i] = 0;
+    }
+
+    void
+    add(SwitchID router)
+    {
+        assert(router < m_size);
+        word(router >> WORD_SHIFT) |= bitOf(router);
+    }
+
+    bool
+    isElement(SwitchID router) const
+    {
+        assert(router < m_size);
+        return (getWord(router >> WORD_SHIFT) & bitOf(router)) != 0;
+    }
+
+    int
+    count() const
+    {
+        int counter = popCount(m_first_word);
+        for (int i = 0; i < m_upper_words.size(); i++)
+            counter += popCount(m_upper_words[i]);
+        return counter;
+    }
+
+    bool
+    isEmpty() const
+    {
+        return m_first_word == 0 && upperWordsEmpty();
+    }
+
+    // True when every destination fits in the native TOPAZ mask
+    bool fitsInFirstWord() const { return upperWordsEmpty(); }
+
+    uint64
+    getWord(int index) const
+    {
+        return index == 0 ? m_first_word : m_upper_words[index - 1];
+    }
+
+    // Returns the smallest router >= start in the set, or getSize()
+    // if there is none. Used to walk the set one router at a time.
+    SwitchID
+    nextElement(SwitchID start) const
+    {
+        int index = start >> WORD_SHIFT;
+        if (index >= getNumWords())
+            return m_size;
+        uint64 bits = getWord(index) & (~0ULL << (start & WORD_MASK));
+        while (bits == 0) {
+            if (++index >= getNumWords())
+                return m_size;
+            bits = getWord(index);
+        }
+        return (index << WORD_SHIFT) + findLsbSet(bits);
+    }
+
+  private:
+    static uint64 bitOf(SwitchID router)
+    { return 1ULL << (router & WORD_MASK); }
+
+    uint64&
+    word(int index)
+    {
+        return index == 0 ? m_first_word : m_upper_words[index - 1];
+    }
+
+    bool
+    upperWordsEmpty() const
+    {
+        for (int i = 0; i < m_upper_words.size(); i++)
+            if (m_upper_words[i])
+                return false;
+        return true;
+    }
+
+    int m_size;
+    uint64 m_first_word;
+    std::vector<uint64> m_upper_words;
+};
+
+#endif // __MEM_RUBY_NETWORK_TOPAZ_TOPAZMULTICASTMASK_HH__
@@ -46,6 +46,10 @@
 #include "mem/ruby/network/topaz/TopazNetwork.hh"
 #include "mem/ruby/network/topaz/TopazSwitch.hh"
 #include "mem/ruby/network/topaz/TopazSwitchFlow.hh"
+#include "mem/ruby/network/topaz/TopazSampler.hh"
+#include "mem/ruby/network/topaz/TopazTicker.hh"
+#include "mem/ruby/network/topaz/TopazWorkerPool.hh"
+#include "debug/Drain.hh"
 #include "debug/RubyNetwork.hh"
 
 
@@ -95,11 +99,12 @@ TopazNetwork::TopazNetwork(const Params *p)
         m_ordered[i] = false;
     }
     m_number_messages=0;
-    m_number_ordered_messages=0;
-    m_number_topaz_ordered_messages=0;
     m_number_topaz_messages=0;
+    m_vnet_messages.resize(m_virtual_networks, 0);
+    m_vnet_topaz_messages.resize(m_virtual_networks, 0);
     m_totalNetMsg=0;
     m_totalTopazMsg=0;
+    m_envelopes_in_use=0;
     m_forward_mapping = new SwitchID[m_nodes];
     m_reverse_mapping.resize(m_nodes);
 
@@ -130,6 +135,35 @@ TopazNetwork::TopazNetwork(const Params *p)
     m_simulName = (p->topaz_network).c_str();
     m_topazInitFile = (p->topaz_init_file).c_str();
     m_topaz_adaptive_interface_threshold = p->topaz_adaptive_interface_threshold;
+    m_hybrid_low_watermark = p->topaz_hybrid_low_watermark;
+    m_hybrid_high_watermark = p->topaz_hybrid_high_watermark;
+    m_hybrid_min_dwell = p->topaz_hybrid_min_dwell;
+    m_topaz_selected = false;
+    m_last_backend_switch = Cycles(0);
+    m_last_hybrid_update = Cycles(0);
+    m_vnet_in_topaz.resize(m_virtual_networks, false);
+    //no list means TOPAZ models every vnet
+    m_vnet_uses_topaz.resize(m_virtual_networks, p->topaz_vnets.empty());
+    for (int i = 0; i < p->topaz_vnets.size(); i++) {
+        int vnet = p->topaz_vnets[i];
+        if (vnet < 0 || vnet >= m_virtual_networks)
+            fatal("topaz_vnets: vnet %d out of range, there are %d vnets\n",
+                  vnet, m_virtual_networks);
+        m_vnet_uses_topaz[vnet] = true;
+    }
+    m_vnet_ruby_busy_at.resize(m_virtual_networks, Cycles(0));
+    m_max_endpoint_latency = Cycles(0);
+    m_topaz_time = 0;
+    m_worker_pool = NULL;
+    m_topaz_worker_threads = p->topaz_worker_threads;
+    m_drain_manager = NULL;
+    m_ticker = NULL;
+    m_sampler = NULL;
+    m_sampling = p->topaz_sampling;
+    m_sample_detailed_window = p->topaz_sample_detailed_window;
+    m_sample_fast_window = p->topaz_sample_fast_window;
+    m_sample_load_buckets = p->topaz_sample_load_buckets;
+    m_sample_confidence = p->topaz_sample_confidence;
 }
 
 void
@@ -140,7 +174,18 @@ TopazNetwork::init()
     // The topology pointer should have already been initialized in
     // the parent class network constructor.
     assert(m_topology_ptr != NULL);
+    m_router_links.resize(m_switch_ptr_vector.size());
     m_topology_ptr->createLinks(this);
+    computeRouterHops();
+
+    // Flat lookup tables so that routing a message only touches its
+    // destinations instead of every MachineType and component
+    m_node_to_machine.resize(m_nodes);
+    m_router_nodes.resize(m_switch_ptr_vector.size());
+    for (NodeID node = 0; node < m_nodes; node++) {
+        m_node_to_machine[node] = _nodeNumber_to_MachineID(node);
+        m_router_nodes[m_forward_mapping[node]].push_back(node);
+    }
     //
     //  TOPAZ INITIALIZATION AND INSTALLERS
     //
@@ -160,7 +205,6 @@ TopazNetwork::init()
     TPZString initString ;
     initString = TPZString("TPZSimul -q -s ") + m_simulName +
                  TPZString (" -t EMPTY -d 100000 -v 4 -F ")+m_topazInitFile;
-    m_firstTrigger=~0;
     //Run each virtual network in a separate phisical netwokr (aka DASH)
     //or just rely on virtual netowkrs
     //the network should be conveived to manage separetelly all
@@ -194,6 +238,20 @@ TopazNetwork::init()
     for (unsigned i = 1; i <= m_unify; i++)
       TPZSIMULATOR()->getSimulation(i)->setPacketLength(
                                          getMessageSizeTopaz(MessageSizeType_Data));
+    m_pending_deliveries.assign(m_unify,
+                                vector<int>(m_switch_ptr_vector.size(), 0));
+    m_routers_awaiting_delivery.resize(m_unify);
+    m_step_deliveries.resize(m_unify);
+    m_step_visits.resize(m_unify, 0);
+    //vnets left to the Ruby switches never reach their simulations
+    for (int vnet = 0; vnet < m_virtual_networks; vnet++) {
+        unsigned simulation = getSimulationIndex(vnet);
+        if (!m_vnet_uses_topaz[vnet])
+            continue;
+        if (m_topaz_simulations.empty() ||
+            m_topaz_simulations.back() != simulation)
+            m_topaz_simulations.push_back(simulation);
+    }
     //Clock ratio
     if (m_processorClockRatio == 0 ) {
        m_processorClockRatio=int(TPZSIMULATOR()->
@@ -201,11 +259,35 @@ TopazNetwork::init()
     }
     //Network cant be faster than memory
     assert(m_processorClockRatio>=1);
+    m_ticker = new TopazTicker(this, Cycles(m_processorClockRatio));
 
     this->enableTopaz();
     //Grab rubys seed and re-set it
     //(Topaz may internally redefine seed if it is defined in SGM
     srandom(g_system_ptr->getRandomSeed());
+
+    if (m_sampling) {
+        m_sampler = new TopazSampler(m_switch_ptr_vector.size(),
+                                     m_virtual_networks,
+                                     m_sample_load_buckets,
+                                     m_sample_detailed_window,
+                                     m_sample_fast_window,
+                                     m_sample_confidence);
+    }
+    //Independent networks (one per vnet) can run side by side
+    //(the Ruby thread counts as one of the workers), as long as the
+    //engine keeps nothing shared between them
+    unsigned workers = min<unsigned>(m_topaz_worker_threads,
+                                     m_topaz_simulations.size());
+    if (workers > 1) {
+#ifdef TPZ_SIMULATIONS_INDEPENDENT
+        m_worker_pool = new TopazWorkerPool(this, workers - 1,
+                                            m_topaz_simulations);
+#else
+        warn("topaz_worker_threads ignored, this TOPAZ shares state "
+             "between its simulations\n");
+#endif
+    }
 }
 
 int TopazNetwork::getMessageSizeTopaz(MessageSizeType size_type) const {
@@ -215,41 +297,92 @@ int TopazNetwork::getMessageSizeTopaz(MessageSizeType size_type) const {
 }
 
 
-bool TopazNetwork::useGemsNetwork(int vnet) {
-    bool useGems = false;
-    // During warmup we use GEMS' network
-    if (inWarmup()) useGems = true;
-    // Messages in order must go all through the same network. If this is an
-    // ordered virtual network, send the message through the network where you
-    // find any message.
-    if (isVNetOrdered(vnet)) {
-        if (numberOfOrderedMessages() > 0) {
-            assert(numberOfTopazOrderedMessages() == 0);
-            useGems = true;
-        }
-        else if (numberOfTopazOrderedMessages() > 0) {
-            useGems = false;
-        }
+//******************************************************************************
+// Hybrid mode: Ruby's SimpleNetwork carries the traffic while the load is
+// light and TOPAZ takes over when it grows. The decision uses two
+// watermarks over the messages in flight plus a minimum dwell time, so a
+// load hovering around a single threshold does not flip the backend every
+// cycle. Ordered vnets only move once the old backend holds none of their
+// messages; until then their endpoints stall (see isVNetDraining).
+//******************************************************************************
+void TopazNetwork::updateHybridMode() {
+    Cycles now = curCycle();
+    if (now == m_last_hybrid_update) return;
+    if (m_topaz_selected)
+        m_cycles_in_topaz += now - m_last_hybrid_update;
+    else
+        m_cycles_in_ruby += now - m_last_hybrid_update;
+    m_last_hybrid_update = now;
+
+    int high = m_hybrid_high_watermark;
+    if (high == 0) high = m_topaz_adaptive_interface_threshold;
+    int low = m_hybrid_low_watermark;
+    if (low == 0 || low > high) low = high;
+
+    bool use_topaz = m_topaz_selected;
+    //only the traffic TOPAZ may carry counts
+    int in_flight = 0;
+    for (int vnet = 0; vnet < m_virtual_networks; vnet++) {
+        if (m_vnet_uses_topaz[vnet])
+            in_flight += m_vnet_messages[vnet] + m_vnet_topaz_messages[vnet];
     }
-    const int messages_in_ruby = numberOfMessages();
-    if (m_number_topaz_messages < 0) {
-        static bool warn_topaz_count_is_wrong = true;
-        if (warn_topaz_count_is_wrong) {
-            DPRINTF(RubyNetwork,"Topaz is not counting messages correctly,");
-            DPRINTF(RubyNetwork," ignoring g_MAX_MESSAGES_THROUGH_GEMS.");
-            DPRINTF(RubyNetwork,"Please, fix topaz if you want to use this parameter.");
-            warn_topaz_count_is_wrong = false;
-        }
-        useGems = false;
+    if (inWarmup()) {
+        // During warmup we use GEMS' network
+        use_topaz = false;
+    } else if (high == 0) {
+        use_topaz = true;
+    } else if (now - m_last_backend_switch >= m_hybrid_min_dwell) {
+        if (!m_topaz_selected && in_flight >= high) use_topaz = true;
+        if (m_topaz_selected && in_flight < low) use_topaz = false;
     }
-    // If the total number of messages is small
-    //(less than m_topaz_adaptive_interface_threshold), we can use SimpleNetwor
-    if ((messages_in_ruby + m_number_topaz_messages) <
-                             m_topaz_adaptive_interface_threshold)
-        useGems = true;
-    else
-        useGems = false;
-    return useGems;
+
+    if (use_topaz != m_topaz_selected) {
+        DPRINTF(RubyNetwork, "Hybrid mode: moving to %s with %d messages "
+                "in flight at %d.\n", use_topaz ? "TOPAZ" : "Ruby",
+                in_flight, now);
+        m_topaz_selected = use_topaz;
+        m_last_backend_switch = now;
+        m_backend_switches++;
+        for (int vnet = 0; vnet < m_virtual_networks; vnet++)
+            m_vnet_ruby_busy_at[vnet] = now;
+    }
+
+    for (int vnet = 0; vnet < m_virtual_networks; vnet++) {
+        if (m_vnet_in_topaz[vnet] == selectedBackend(vnet)) continue;
+        // Messages in order must go all through the same network
+        if (!isVNetOrdered(vnet) || backendDrained(vnet))
+            m_vnet_in_topaz[vnet] = selectedBackend(vnet);
+    }
+}
+
+//******************************************************************************
+// True when the network a vnet is leaving no longer holds any of its
+// messages. The Ruby count drops when a message is routed to its ejection
+// link, so the ejection buffers and the link latency have to be waited for.
+//******************************************************************************
+bool TopazNetwork::backendDrained(int vnet) {
+    if (m_vnet_in_topaz[vnet])
+        return m_vnet_topaz_messages[vnet] == 0;
+
+    Cycles now = curCycle();
+    bool busy = m_vnet_messages[vnet] > 0;
+    for (int i = 0; !busy && i < m_switch_ptr_vector.size(); i++)
+        busy = m_switch_ptr_vector[i]->hasPendingEjections(vnet);
+    if (busy) {
+        m_vnet_ruby_busy_at[vnet] = now;
+        return false;
+    }
+    return now - m_vnet_ruby_busy_at[vnet] > m_max_endpoint_latency;
+}
+
+bool TopazNetwork::useGemsNetwork(int vnet) {
+    updateHybridMode();
+    return !m_vnet_in_topaz[vnet];
+}
+
+bool TopazNetwork::isVNetDraining(int vnet) {
+    updateHybridMode();
+    return m_vnet_in_topaz[vnet] != selectedBackend(vnet);
 }
 
 void TopazNetwork::enableTopaz(){
@@ -289,8 +422,14 @@ TopazNetwork::~TopazNetwork()
   //      deletePointers(m_toNetQueues[i]);
   //      deletePointers(m_fromNetQueues[i]);
   //  }
+    delete m_ticker;
+    delete m_worker_pool;
+    delete m_sampler;
     deletePointers(m_switch_ptr_vector);
     deletePointers(m_buffers_to_free);
+    deletePointers(m_free_envelopes);
+    deletePointers(m_network_latency_hist);
+    deletePointers(m_hops_hist);
     // delete m_topology_ptr;
 }
 
@@ -308,7 +447,9 @@ TopazNetwork::makeOutLink(SwitchID src, NodeID dest, BasicLink* link,
 
     m_switch_ptr_vector[src]->addOutPort(m_fromNetQueues[dest], routing_table_entry,
                                 simple_link->m_latency,
-                                simple_link->m_bw_multiplier);
+                                simple_link->m_bw_multiplier, true);
+    if (simple_link->m_latency > m_max_endpoint_latency)
+        m_max_endpoint_latency = simple_link->m_latency;
 
     m_endpoint_switches[dest] = m_switch_ptr_vector[src];
 }
@@ -321,7 +462,7 @@ TopazNetwork::makeInLink(NodeID src, SwitchID dest, BasicLink* link,
                           const NetDest& routing_table_entry)
 {
     assert(src < m_nodes);
-    m_switch_ptr_vector[dest]->addInPort(m_toNetQueues[src]);
+    m_switch_ptr_vector[dest]->addInPort(m_toNetQueues[src], true);
 }
 
 // From a switch to a switch
@@ -354,6 +495,34 @@ TopazNetwork::makeInternalLink(SwitchID src, SwitchID dest, BasicLink* link,
     m_switch_ptr_vector[src]->addOutPort(queues, routing_table_entry,
                                 simple_link->m_latency,
                                 simple_link->m_bw_multiplier);
+    m_router_links[src].push_back(dest);
+}
+
+//******************************************************************************
+// TOPAZ does not report the route of a packet, so hops are taken from the
+// router graph of the Ruby topology, which TOPAZ router numbers follow.
+//******************************************************************************
+void
+TopazNetwork::computeRouterHops()
+{
+    int routers = m_switch_ptr_vector.size();
+    m_router_hops.assign(routers, vector<int>(routers, -1));
+    vector<SwitchID> frontier;
+    for (SwitchID src = 0; src < routers; src++) {
+        vector<int>& hops = m_router_hops[src];
+        hops[src] = 0;
+        frontier.assign(1, src);
+        for (int i = 0; i < frontier.size(); i++) {
+            SwitchID router = frontier[i];
+            for (int j = 0; j < m_router_links[router].size(); j++) {
+                SwitchID next = m_router_links[router][j];
+                if (hops[next] < 0) {
+                    hops[next] = hops[router] + 1;
+                    frontier.push_back(next);
+                }
+            }
+        }
+    }
 }
 
 void
@@ -441,6 +610,156 @@ TopazNetwork::regStats()
             m_msg_counts[(unsigned int) type] * Stats::constant(
                     Network::MessageSizeType_to_int(type));
     }
+
+    m_delivery_node_visits
+        .name(name() + ".delivery_node_visits")
+        .flags(Stats::nozero)
+        ;
+    m_delivered_packets
+        .name(name() + ".delivered_packets")
+        .flags(Stats::nozero)
+        ;
+    m_node_visits_per_delivery
+        .name(name() + ".node_visits_per_delivery")
+        .flags(Stats::nozero)
+        ;
+    m_node_visits_per_delivery = m_delivery_node_visits / m_delivered_packets;
+
+    m_msg_clones
+        .name(name() + ".msg_clones")
+        .flags(Stats::nozero)
+        ;
+    m_msg_clones_avoided
+        .name(name() + ".msg_clones_avoided")
+        .flags(Stats::nozero)
+        ;
+
+    m_envelope_allocations
+        .name(name() + ".envelope_allocations")
+        .flags(Stats::nozero)
+        ;
+    m_envelope_reuses
+        .name(name() + ".envelope_reuses")
+        .flags(Stats::nozero)
+        ;
+    m_envelope_occupancy
+        .name(name() + ".envelope_occupancy")
+        .flags(Stats::nozero)
+        ;
+    m_envelope_high_water
+        .name(name() + ".envelope_high_water")
+        .flags(Stats::nozero)
+        ;
+
+    m_cycles_in_ruby
+        .name(name() + ".hybrid_cycles_in_ruby")
+        .flags(Stats::nozero)
+        ;
+    m_cycles_in_topaz
+        .name(name() + ".hybrid_cycles_in_topaz")
+        .flags(Stats::nozero)
+        ;
+    m_backend_switches
+        .name(name() + ".hybrid_backend_switches")
+        .flags(Stats::nozero)
+        ;
+
+    m_topaz_steps
+        .name(name() + ".topaz_steps")
+        .flags(Stats::nozero)
+        ;
+    m_topaz_host_seconds
+        .name(name() + ".topaz_host_seconds")
+        .flags(Stats::nozero)
+        ;
+    m_host_seconds_per_step
+        .name(name() + ".topaz_host_seconds_per_step")
+        .flags(Stats::nozero)
+        ;
+    m_host_seconds_per_step = m_topaz_host_seconds / m_topaz_steps;
+
+    m_flits_injected
+        .init(m_virtual_networks)
+        .name(name() + ".flits_injected")
+        .flags(Stats::pdf | Stats::total | Stats::nozero | Stats::oneline)
+        ;
+    m_flits_received
+        .init(m_virtual_networks)
+        .name(name() + ".flits_received")
+        .flags(Stats::pdf | Stats::total | Stats::nozero | Stats::oneline)
+        ;
+    m_packets_received
+        .init(m_virtual_networks)
+        .name(name() + ".packets_received")
+        .flags(Stats::pdf | Stats::total | Stats::nozero | Stats::oneline)
+        ;
+    m_network_latency
+        .init(m_virtual_networks)
+        .name(name() + ".network_latency")
+        .flags(Stats::oneline)
+        ;
+    m_queueing_latency
+        .init(m_virtual_networks)
+        .name(name() + ".queueing_latency")
+        .desc("cycles waited in the bridge input buffers, per delivery")
+        .flags(Stats::oneline)
+        ;
+    m_hops
+        .init(m_virtual_networks)
+        .name(name() + ".hops")
+        .flags(Stats::oneline)
+        ;
+
+    for (int i = 0; i < m_virtual_networks; i++) {
+        m_flits_injected.subname(i, csprintf("vnet-%i", i));
+        m_flits_received.subname(i, csprintf("vnet-%i", i));
+        m_packets_received.subname(i, csprintf("vnet-%i", i));
+        m_network_latency.subname(i, csprintf("vnet-%i", i));
+        m_queueing_latency.subname(i, csprintf("vnet-%i", i));
+        m_hops.subname(i, csprintf("vnet-%i", i));
+
+        m_network_latency_hist.push_back(new Stats::Histogram());
+        m_network_latency_hist[i]
+            ->init(10)
+            .name(name() + csprintf(".network_latency_hist.vnet-%i", i))
+            .flags(Stats::nozero | Stats::pdf | Stats::oneline);
+
+        m_hops_hist.push_back(new Stats::Histogram());
+        m_hops_hist[i]
+            ->init(10)
+            .name(name() + csprintf(".hops_hist.vnet-%i", i))
+            .flags(Stats::nozero | Stats::pdf | Stats::oneline);
+    }
+
+    m_avg_vnet_latency
+        .name(name() + ".average_vnet_latency")
+        .flags(Stats::oneline);
+    m_avg_vnet_latency = m_network_latency / m_packets_received;
+
+    m_avg_vqueue_latency
+        .name(name() + ".average_vqueue_latency")
+        .flags(Stats::oneline);
+    m_avg_vqueue_latency = m_queueing_latency / m_packets_received;
+
+    m_avg_vnet_hops
+        .name(name() + ".average_vnet_hops")
+        .flags(Stats::oneline);
+    m_avg_vnet_hops = m_hops / m_packets_received;
+
+    m_router_flits_received
+        .init(m_switch_ptr_vector.size())
+        .name(name() + ".router_flits_received")
+        .flags(Stats::nozero | Stats::oneline)
+        ;
+    m_router_flits_per_cycle
+        .init(m_switch_ptr_vector.size())
+        .name(name() + ".router_flits_per_cycle")
+        .flags(Stats::nozero | Stats::oneline)
+        ;
+
+    m_ticker->regStats(name(), m_host_seconds_per_step);
+    if (m_sampler)
+        m_sampler->regStats(name());
 }
 
 
@@ -450,6 +769,13 @@ TopazNetwork::collateStats()
     for (int i = 0; i < m_switch_ptr_vector.size(); i++) {
         m_switch_ptr_vector[i]->collateStats();
     }
+    double sim_cycles = (double)(curCycle() - g_ruby_start);
+    for (int i = 0; i < m_switch_ptr_vector.size(); i++) {
+        m_router_flits_per_cycle[i] =
+            m_router_flits_received[i].value() / sim_cycles;
+    }
+    if (m_sampler)
+        m_sampler->collateStats();
     cout<<"<TOPAZ>"<<endl;
     cout<<"Ratio Processor Clock/Network Clock = "<<m_processorClockRatio<<endl;
     cout<<"Flit size in bytes                  = "<<m_flitSize<<" bytes"<<endl;
@@ -535,41 +861,281 @@ TopazNetwork::print(ostream& out) const
     out << endl;
 }
 
-void TopazNetwork::increaseNumMsg(int num){
+void TopazNetwork::increaseNumMsg(int vnet, int num){
     m_number_messages+=num;
+    m_vnet_messages[vnet]+=num;
+    m_totalNetMsg+=num;
 }
 
-void TopazNetwork::increaseNumTopazMsg(int num){
+void TopazNetwork::increaseNumTopazMsg(int vnet, int num, bool sampled){
     m_number_topaz_messages+=num;
+    m_vnet_topaz_messages[vnet]+=num;
     m_totalTopazMsg+=num;
+    if (sampled)
+        m_sampler->increaseInFlight(vnet, num);
+}
+
+void TopazNetwork::decreaseNumMsg(int vnet, int num){
+    m_number_messages-=num;
+    m_vnet_messages[vnet]-=num;
+    assert(m_vnet_messages[vnet] >= 0);
+    if (m_drain_manager)
+        testDrainComplete();
+}
+
+void TopazNetwork::decreaseNumTopazMsg (int vnet, bool sampled){
+    m_number_topaz_messages--;
+    m_vnet_topaz_messages[vnet]--;
+    assert(m_vnet_topaz_messages[vnet] >= 0);
+    if (sampled)
+        m_sampler->decreaseInFlight(vnet);
+    if (m_drain_manager)
+        testDrainComplete();
 }
 
-void TopazNetwork::decreaseNumMsg(int vnet){
-    m_number_messages--;
-    assert(m_number_messages >= 0);
-    if (m_ordered[vnet]){
-        if ( numberOfOrderedMessages() > 0 ){
-            assert(!(numberOfTopazOrderedMessages()>0));
-            m_number_ordered_messages--;
+//******************************************************************************
+// TOPAZ only reports arrivals when asked router by router. Instead of asking
+// every router each cycle, count the packets injected towards each one and
+// only poll routers that still expect something.
+//******************************************************************************
+void TopazNetwork::notifyInjection(int vnet, SwitchID router) {
+    unsigned simulation = getSimulationIndex(vnet);
+    vector<int>& pending = m_pending_deliveries[simulation - 1];
+    assert(router < pending.size());
+    if (pending[router]++ == 0)
+        m_routers_awaiting_delivery[simulation - 1].push_back(router);
+}
+
+int TopazNetwork::collectDeliveries(unsigned simulation_index,
+                                    vector<TopazDelivery>& delivered) {
+    TPZSimulation* simulation = TPZSIMULATOR()->getSimulation(simulation_index);
+    vector<int>& pending = m_pending_deliveries[simulation_index - 1];
+    vector<SwitchID>& awaiting =
+                      m_routers_awaiting_delivery[simulation_index - 1];
+    unsigned kept = 0;
+    int visits = awaiting.size();
+    for (unsigned i = 0; i < awaiting.size(); i++) {
+        SwitchID router = awaiting[i];
+        TPZPosition position =
+            simulation->getNetwork()->CreatePosition(router);
+        void* ptr = simulation->getExternalInfoAt(position);
+        if (ptr != NULL) {
+            TopazDelivery delivery = {router, static_cast<MessageTopaz*>(ptr)};
+            delivered.push_back(delivery);
+            assert(pending[router] > 0);
+            pending[router]--;
         }
+        if (pending[router] > 0)
+            awaiting[kept++] = router;
     }
+    awaiting.resize(kept);
+    return visits;
 }
 
-void TopazNetwork::decreaseNumTopazMsg (int vnet){
-    m_number_topaz_messages--;
-    assert(m_number_messages >= 0);
-    if ( m_ordered[vnet] ){
-        assert(!(numberOfOrderedMessages()>0));
-        m_number_topaz_ordered_messages--;
+void TopazNetwork::sendTopazMessage(int vnet, const TPZMessage& msg) {
+    unsigned simulation = getSimulationIndex(vnet);
+    TPZSIMULATOR()->getSimulation(simulation)->getNetwork()->sendMessage(msg);
+}
+
+//******************************************************************************
+// Runs network cycle time in one simulation and keeps what it delivered
+// apart, so several simulations can be stepped at once. The ticker runs in
+// every cycle in which a simulation has work to do, so the cycles since the
+// previous step had none and the clock just moves over them.
+//******************************************************************************
+void TopazNetwork::stepSimulation(unsigned simulation_index, uTIME time) {
+    TPZSimulation* simulation = TPZSIMULATOR()->getSimulation(simulation_index);
+    simulation->setCurrentTime(time - 1);
+    simulation->run(1);
+    vector<TopazDelivery>& delivered = m_step_deliveries[simulation_index - 1];
+    delivered.clear();
+    m_step_visits[simulation_index - 1] =
+        collectDeliveries(simulation_index, delivered);
+}
+
+int TopazNetwork::stepSimulations(uTIME time,
+                                  vector<TopazDelivery>& delivered) {
+    if (m_worker_pool) {
+        m_worker_pool->run(time);
+    } else {
+        for (unsigned i = 0; i < m_topaz_simulations.size(); i++)
+            stepSimulation(m_topaz_simulations[i], time);
+    }
+    int visits = 0;
+    for (unsigned i = 0; i < m_topaz_simulations.size(); i++) {
+        unsigned simulation = m_topaz_simulations[i];
+        delivered.insert(delivered.end(),
+                         m_step_deliveries[simulation - 1].begin(),
+                         m_step_deliveries[simulation - 1].end());
+        visits += m_step_visits[simulation - 1];
     }
+    return visits;
 }
 
-void TopazNetwork::increaseNumOrderedMsg(int num){
-    m_number_ordered_messages+=num;
+//******************************************************************************
+// Simulates network cycle time and returns the packets to deliver now
+//******************************************************************************
+void TopazNetwork::advanceTopaz(uTIME time,
+                                vector<TopazDelivery>& delivered) {
+    //In the fast windows of the sampled mode TOPAZ is only stepped while
+    //it still holds packets of the previous detailed window
+    bool step = !m_sampler ||
+                m_number_topaz_messages > m_sampler->getInFlight();
+    int visits = 0;
+    if (step)
+        visits = stepSimulations(time, delivered);
+    m_topaz_time = time;
+    if (m_sampler)
+        m_sampler->collect(g_system_ptr->curCycle(), delivered);
+    m_delivery_node_visits += visits;
+    m_delivered_packets += delivered.size();
 }
 
-void TopazNetwork::increaseNumTopazOrderedMsg(int num){
-    m_number_topaz_ordered_messages+=num;
+//******************************************************************************
+// Network cycle of the next tick after the one of time: the cycle after the
+// first one in which a simulation has work to do (it is stepped in the tick
+// that follows), or the one a sampled message is due in. Engines that cannot
+// tell are stepped every network cycle.
+//******************************************************************************
+uTIME TopazNetwork::getNextTopazTime(uTIME time) {
+#ifdef TPZ_NEXT_EVENT_TIME
+    uTIME next = TPZ_NO_EVENT;
+    for (unsigned i = 0; i < m_topaz_simulations.size(); i++) {
+        uTIME event = TPZSIMULATOR()->getSimulation(m_topaz_simulations[i])->
+                                                  nextEventTime();
+        if (event != TPZ_NO_EVENT)
+            next = min(next, event + 1);
+    }
+    if (m_sampler && m_sampler->hasPending()) {
+        uint64 due = m_sampler->getNextDue();
+        next = min(next, uTIME((due + m_processorClockRatio - 1) /
+                               m_processorClockRatio));
+    }
+    //nothing TOPAZ can place in time, keep stepping every cycle
+    if (next == TPZ_NO_EVENT)
+        return time + 1;
+    return max(next, time + 1);
+#else
+    return time + 1;
+#endif
+}
+
+//******************************************************************************
+// MessageTopaz envelopes are recycled through a free list, so saturating
+// traffic does not pay a malloc/free pair per injected packet.
+//******************************************************************************
+MessageTopaz* TopazNetwork::allocateMessageTopaz() {
+    MessageTopaz* envelope;
+    if (m_free_envelopes.empty()) {
+        envelope = new MessageTopaz;
+        m_envelope_allocations++;
+    } else {
+        envelope = m_free_envelopes.back();
+        m_free_envelopes.pop_back();
+        m_envelope_reuses++;
+    }
+    m_envelopes_in_use++;
+    m_envelope_occupancy++;
+    if (m_envelopes_in_use > m_envelope_high_water.value())
+        m_envelope_high_water = m_envelopes_in_use;
+    return envelope;
+}
+
+void TopazNetwork::releaseMessageTopaz(MessageTopaz* envelope) {
+    assert(m_envelopes_in_use > 0);
+    // drop the reference so the Ruby message is freed now, not on reuse
+    envelope->message = NULL;
+    m_free_envelopes.push_back(envelope);
+    m_envelopes_in_use--;
+    m_envelope_occupancy--;
+}
+
+void TopazNetwork::activateTicker() {
+    m_ticker->activate();
+}
+
+//******************************************************************************
+// A message is shared by all of its destinations until one of them has to
+// enqueue it. MessageBuffer::enqueue stamps per-destination timing into
+// the message, so every destination but the last one gets a private copy
+// and the last one takes the shared message itself.
+//******************************************************************************
+MsgPtr TopazNetwork::messageForDestination(const MsgPtr& shared,
+                                           bool last) {
+    if (last) {
+        m_msg_clones_avoided++;
+        return shared;
+    }
+    m_msg_clones++;
+    return shared->clone();
+}
+
+//******************************************************************************
+// Statistics of the traffic going through TOPAZ. They are taken as packets
+// cross the bridge, so stats resets and periodic dumps behave as in the
+// other networks.
+//******************************************************************************
+void TopazNetwork::recordInjection(int vnet, int flits) {
+    m_flits_injected[vnet] += flits;
+}
+
+void TopazNetwork::recordDelivery(const MessageTopaz* envelope,
+                                  SwitchID router) {
+    int vnet = envelope->vnet;
+    Cycles latency = g_system_ptr->curCycle() - envelope->injection_time;
+    int hops = m_router_hops[envelope->source][router];
+    m_packets_received[vnet]++;
+    m_flits_received[vnet] += envelope->flits;
+    m_network_latency[vnet] += latency;
+    m_queueing_latency[vnet] += envelope->queueing_latency;
+    m_network_latency_hist[vnet]->sample(latency);
+    if (hops >= 0) {
+        m_hops[vnet] += hops;
+        m_hops_hist[vnet]->sample(hops);
+    }
+    m_router_flits_received[router] += envelope->flits;
+    if (m_sampler && !envelope->sampled) {
+        m_sampler->recordLatency(envelope->source, router, vnet,
+                                 envelope->load_bucket, hops, latency,
+                                 g_system_ptr->curCycle());
+    }
+}
+
+//******************************************************************************
+// Sampled mode. Unordered vnets follow the window in progress. An ordered
+// vnet only changes path once it has no messages left on the other one,
+// so its messages are never reordered.
+//******************************************************************************
+bool TopazNetwork::useSampledPath(int vnet) {
+    if (!m_sampler)
+        return false;
+    bool fast = m_sampler->inFastWindow(g_system_ptr->curCycle());
+    if (!m_ordered[vnet])
+        return fast;
+    int sampled = m_sampler->getInFlight(vnet);
+    int detailed = m_vnet_topaz_messages[vnet] - sampled;
+    return fast ? detailed == 0 : sampled > 0;
+}
+
+int TopazNetwork::getLoadBucket() const {
+    if (!m_sampler)
+        return 0;
+    return m_sampler->getLoadBucket(m_number_topaz_messages);
+}
+
+void TopazNetwork::sendSampledMessage(MessageTopaz* envelope,
+                                      SwitchID router) {
+    int hops = m_router_hops[envelope->source][router];
+    // only used until TOPAZ has shown some latency for the distance
+    Cycles zero_load((max(hops, 0) + envelope->flits) *
+                     m_processorClockRatio);
+    Cycles latency = m_sampler->drawLatency(envelope->source, router,
+                                            envelope->vnet,
+                                            envelope->load_bucket, hops,
+                                            zero_load);
+    m_sampler->schedule(envelope, router,
+                        g_system_ptr->curCycle() + latency,
+                        m_ordered[envelope->vnet]);
 }
 
 void TopazNetwork::setTopazMapping (SwitchID ext_node, SwitchID int_node) {
@@ -579,6 +1145,95 @@ void TopazNetwork::setTopazMapping (SwitchID ext_node, SwitchID int_node) {
     m_reverse_mapping[int_node].add(machine);
 }
 
+//******************************************************************************
+// Checkpoints. Draining lets the messages in flight reach their destination
+// queues, the ticker keeps stepping TOPAZ until it is empty. Once drained,
+// TOPAZ, the Ruby switches and the bridge input buffers hold nothing, so
+// only the counters and the backend each vnet uses have to be saved.
+//******************************************************************************
+bool
+TopazNetwork::isEmpty() const
+{
+    if (m_number_messages != 0 || m_number_topaz_messages != 0)
+        return false;
+    // messages still waiting in the input buffers are in neither count
+    for (int i = 0; i < m_switch_ptr_vector.size(); i++) {
+        if (m_switch_ptr_vector[i]->hasPendingInjections())
+            return false;
+    }
+    return true;
+}
+
+unsigned int
+TopazNetwork::drain(DrainManager *dm)
+{
+    if (isEmpty()) {
+        m_drain_manager = NULL;
+        setDrainState(Drainable::Drained);
+        return 0;
+    }
+    DPRINTF(Drain, "TopazNetwork not drained, %d messages in Ruby and %d "
+            "in TOPAZ\n", m_number_messages, m_number_topaz_messages);
+    m_drain_manager = dm;
+    setDrainState(Drainable::Draining);
+    return 1;
+}
+
+void
+TopazNetwork::testDrainComplete()
+{
+    if (!isEmpty())
+        return;
+    DPRINTF(Drain, "TopazNetwork done draining, signaling drain done\n");
+    setDrainState(Drainable::Drained);
+    m_drain_manager->signalDrainDone();
+    m_drain_manager = NULL;
+}
+
+void
+TopazNetwork::serialize(ostream &os)
+{
+    assert(isEmpty());
+
+    SERIALIZE_SCALAR(m_totalNetMsg);
+    SERIALIZE_SCALAR(m_totalTopazMsg);
+    SERIALIZE_SCALAR(m_in_warmup);
+    SERIALIZE_SCALAR(m_topaz_selected);
+    uint64 topaz_time = m_topaz_time;
+    SERIALIZE_SCALAR(topaz_time);
+    uint64 last_backend_switch = m_last_backend_switch;
+    SERIALIZE_SCALAR(last_backend_switch);
+    uint64 last_hybrid_update = m_last_hybrid_update;
+    SERIALIZE_SCALAR(last_hybrid_update);
+    vector<int> vnet_in_topaz(m_vnet_in_topaz.begin(),
+                              m_vnet_in_topaz.end());
+    arrayParamOut(os, "vnet_in_topaz", vnet_in_topaz);
+}
+
+void
+TopazNetwork::unserialize(Checkpoint *cp, const string &section)
+{
+    UNSERIALIZE_SCALAR(m_totalNetMsg);
+    UNSERIALIZE_SCALAR(m_totalTopazMsg);
+    UNSERIALIZE_SCALAR(m_in_warmup);
+    UNSERIALIZE_SCALAR(m_topaz_selected);
+    uint64 topaz_time;
+    UNSERIALIZE_SCALAR(topaz_time);
+    m_topaz_time = topaz_time;
+    uint64 last_backend_switch;
+    UNSERIALIZE_SCALAR(last_backend_switch);
+    m_last_backend_switch = Cycles(last_backend_switch);
+    uint64 last_hybrid_update;
+    UNSERIALIZE_SCALAR(last_hybrid_update);
+    m_last_hybrid_update = Cycles(last_hybrid_update);
+    vector<int> vnet_in_topaz;
+    arrayParamIn(cp, section, "vnet_in_topaz", vnet_in_topaz);
+    if (vnet_in_topaz.size() != m_virtual_networks)
+        fatal("TopazNetwork checkpoint has %d vnets, expected %d\n",
+              vnet_in_topaz.size(), m_virtual_networks);
+    m_vnet_in_topaz.assign(vnet_in_topaz.begin(), vnet_in_topaz.end());
+}
+
 TopazNetwork *
 TopazNetworkParams::create()
 {
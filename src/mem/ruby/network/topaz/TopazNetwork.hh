@@ -36,14 +36,18 @@
 
 #include "mem/ruby/common/Global.hh"
 #include "mem/ruby/network/Network.hh"
+#include "mem/ruby/network/topaz/TopazWorkerPool.hh"
 #include "mem/ruby/slicc_interface/NetworkMessage.hh"
 #include "params/TopazNetwork.hh"
 #include "sim/sim_object.hh"
 
 //Main simulator include. Download simulator from
-//http://www.atc.unican.es/topaz/ and follow the guide
+//http://www.atc.unican.es/topaz/ and follow the guide, or build with
+//USE_TOPAZ=Reference to use the in-tree engine in topaz/reference
 #include <TPZSimulator.hpp>
 
+//Envelope carried through TOPAZ. All the packets of a message share it and
+//the message itself is only copied for destinations that need their own.
 struct MessageTopaz{
     MsgPtr message;
     int    vnet;
@@ -51,17 +55,33 @@ struct MessageTopaz{
     int    destinations;
     int    bcast;
     int    id;
-    //multicast support
-    std::vector<std::vector<int> > Vector_aux;
+    // for the statistics: where and when it entered TOPAZ, and its size
+    SwitchID source;
+    Cycles injection_time;
+    int    flits;
+    // cycles spent in the bridge input buffer before entering TOPAZ
+    Cycles queueing_latency;
+    // load when injected, and whether it skipped TOPAZ (sampled mode)
+    int    load_bucket;
+    bool   sampled;
+};
+
+// A packet handed back by TOPAZ at the router it was delivered to
+struct TopazDelivery
+{
+    SwitchID m_router;
+    MessageTopaz* m_message;
 };
 
 class NetDest;
 class MessageBuffer;
 class Throttle;
 class TopazSwitch;
+class TopazTicker;
+class TopazSampler;
 class Topology;
 
-class TopazNetwork : public Network
+class TopazNetwork : public Network, public TopazStepper
 {
   public:
     typedef TopazNetworkParams Params;
@@ -84,29 +104,52 @@ class TopazNetwork : public Network
     unsigned getUnifiy() { return m_unify; }
     int getNetSize() { return m_switch_ptr_vector.size(); }
     int getMessageSizeTopaz(MessageSizeType size_type) const;
-    int getTriggerSwitch() const { return m_firstTrigger; }
-    void setTriggerSwitch(int router) {	m_firstTrigger=router; }
     const bool inWarmup() { return m_in_warmup; }
     bool useGemsNetwork(int vnet);
+    bool isVNetDraining(int vnet);
     void enableTopaz();
     void disableTopaz();
-    void increaseNumMsg(int num);
-    void decreaseNumMsg(int vnet);
-    void increaseNumOrderedMsg(int num);
-    void increaseNumTopazOrderedMsg (int num);
-    void increaseNumTopazMsg(int num);
-    void decreaseNumTopazMsg (int vnet);
+    void increaseNumMsg(int vnet, int num);
+    void decreaseNumMsg(int vnet, int num);
+    void increaseNumTopazMsg(int vnet, int num, bool sampled = false);
+    void decreaseNumTopazMsg (int vnet, bool sampled = false);
     int getTopazMessages() { return m_number_topaz_messages; }
     void increaseTotalMsg (int num) { m_totalNetMsg+=num; }
     int getTotalMsg () { return m_totalNetMsg; }
     int getTotalTopazMsg() { return m_totalTopazMsg; }
     const int numberOfMessages() { return m_number_messages; }
-    const int numberOfOrderedMessages() { return m_number_ordered_messages; }
-    const int numberOfTopazOrderedMessages() { return m_number_topaz_ordered_messages; }
     const int numberOfTopazMessages() { return m_number_topaz_messages; }
     void setTopazMapping (SwitchID node0, SwitchID node1);
     SwitchID getSwitch(int ext_node) { return m_forward_mapping[ext_node]; }
+    //simulation carrying a vnet, they are numbered from 1 as in TOPAZ
+    unsigned getSimulationIndex(int vnet) const
+    { return m_unify == 1 ? 1 : vnet + 1; }
+    void sendTopazMessage(int vnet, const TPZMessage& msg);
+    void notifyInjection(int vnet, SwitchID router);
+    int collectDeliveries(unsigned simulation,
+                          std::vector<TopazDelivery>& delivered);
+    void stepSimulation(unsigned simulation, uTIME time);
+    int stepSimulations(uTIME time, std::vector<TopazDelivery>& delivered);
+    void advanceTopaz(uTIME time, std::vector<TopazDelivery>& delivered);
+    uTIME getTopazTime() const { return m_topaz_time; }
+    uTIME getNextTopazTime(uTIME time);
+    bool useSampledPath(int vnet);
+    int getLoadBucket() const;
+    void sendSampledMessage(MessageTopaz* envelope, SwitchID router);
+    MessageTopaz* allocateMessageTopaz();
+    void releaseMessageTopaz(MessageTopaz* envelope);
+    MsgPtr messageForDestination(const MsgPtr& shared, bool last);
+    void activateTicker();
+    void increaseClonesAvoided() { m_msg_clones_avoided++; }
+    void recordTopazStep(double host_seconds)
+    { m_topaz_steps++; m_topaz_host_seconds += host_seconds; }
+    void recordInjection(int vnet, int flits);
+    void recordDelivery(const MessageTopaz* envelope, SwitchID router);
     NetDest getMachines(SwitchID sid) { return m_reverse_mapping[sid]; }
+    MachineID getMachineID(NodeID node) const
+    { return m_node_to_machine[node]; }
+    const std::vector<NodeID>& getRouterNodes(SwitchID sid) const
+    { return m_router_nodes[sid]; }
     MessageBuffer* getToSimNetQueue(NodeID id, bool ordered, int network_num);
     MessageBuffer* getFromSimNetQueue(NodeID id, bool ordered, int network_num);
 //TOPAZ
@@ -142,7 +185,20 @@ class TopazNetwork : public Network
     bool functionalRead(Packet *pkt);
     uint32_t functionalWrite(Packet *pkt);
 
+    unsigned int drain(DrainManager *dm);
+    void checkDrain() { if (m_drain_manager) testDrainComplete(); }
+    void serialize(std::ostream &os);
+    void unserialize(Checkpoint *cp, const std::string &section);
+
   private:
+    void updateHybridMode();
+    //true when the hybrid mode wants the vnet in TOPAZ
+    bool selectedBackend(int vnet) const
+    { return m_topaz_selected && m_vnet_uses_topaz[vnet]; }
+    void testDrainComplete();
+    bool isEmpty() const;
+    void computeRouterHops();
+    bool backendDrained(int vnet);
     void checkNetworkAllocation(NodeID id, bool ordered, int network_num);
     void addLink(SwitchID src, SwitchID dest, int link_latency);
     void makeLink(SwitchID src, SwitchID dest,
@@ -154,23 +210,76 @@ class TopazNetwork : public Network
     unsigned m_processorClockRatio;
     unsigned m_flitSize;
     unsigned m_unify;
-    int m_firstTrigger;
     bool m_in_warmup;
     unsigned m_permanentDisable;
     int m_number_messages;
-    int m_number_ordered_messages;
-    int m_number_topaz_ordered_messages;
     int m_number_topaz_messages;
+    //in-flight messages of each vnet in the Ruby network and in TOPAZ
+    std::vector<int> m_vnet_messages;
+    std::vector<int> m_vnet_topaz_messages;
     //maps each MachineID to the internal node it is connected to
     SwitchID *m_forward_mapping;
     //maps each internal node to the MachineIDs it connects.
     std::vector<NetDest> m_reverse_mapping;
+    //flat versions of the mappings above, built once in init()
+    //maps each node number to its MachineID
+    std::vector<MachineID> m_node_to_machine;
+    //maps each internal node to the node numbers it connects
+    std::vector<std::vector<NodeID> > m_router_nodes;
     int m_totalNetMsg;
     int m_totalTopazMsg;
     TPZString m_simulName;
     TPZString m_topazInitFile;
     unsigned m_block_size;
     unsigned m_topaz_adaptive_interface_threshold;
+    //Hybrid Ruby/TOPAZ mode. Traffic moves to TOPAZ when the in-flight
+    //messages reach the high watermark and back below the low one, never
+    //sooner than m_hybrid_min_dwell cycles after the previous switch.
+    int m_hybrid_low_watermark;
+    int m_hybrid_high_watermark;
+    Cycles m_hybrid_min_dwell;
+    bool m_topaz_selected;
+    Cycles m_last_backend_switch;
+    Cycles m_last_hybrid_update;
+    //network each vnet is using. Ordered vnets keep the old one until
+    //it has no messages of theirs left (drain-and-switch)
+    std::vector<bool> m_vnet_in_topaz;
+    //vnets modeled by TOPAZ, the others always use the Ruby switches
+    std::vector<bool> m_vnet_uses_topaz;
+    //simulations carrying a vnet of m_vnet_uses_topaz, the only ones
+    //stepped
+    std::vector<unsigned> m_topaz_simulations;
+    //last cycle an ordered vnet was seen with Ruby messages in flight
+    std::vector<Cycles> m_vnet_ruby_busy_at;
+    Cycles m_max_endpoint_latency;
+    //links between routers and the hops between each pair of them
+    std::vector<std::vector<SwitchID> > m_router_links;
+    std::vector<std::vector<int> > m_router_hops;
+    //packets still to be delivered at each TOPAZ router, per simulation
+    std::vector<std::vector<int> > m_pending_deliveries;
+    //routers with m_pending_deliveries > 0, the only ones polled
+    std::vector<std::vector<SwitchID> > m_routers_awaiting_delivery;
+    //what each simulation delivered in the last network cycle
+    std::vector<std::vector<TopazDelivery> > m_step_deliveries;
+    std::vector<int> m_step_visits;
+    //envelopes returned by delivered messages, reused by new injections
+    std::vector<MessageTopaz*> m_free_envelopes;
+    int m_envelopes_in_use;
+    //last network cycle handed to TOPAZ
+    uTIME m_topaz_time;
+    //steps TOPAZ on the network clock while it holds packets
+    TopazTicker* m_ticker;
+    TopazWorkerPool* m_worker_pool;
+    unsigned m_topaz_worker_threads;
+    //set while a drain waits for the in-flight messages to arrive
+    DrainManager* m_drain_manager;
+    //sampled mode, NULL when every message goes through TOPAZ
+    TopazSampler* m_sampler;
+    bool m_sampling;
+    Cycles m_sample_detailed_window;
+    Cycles m_sample_fast_window;
+    unsigned m_sample_load_buckets;
+    double m_sample_confidence;
 
     // Private copy constructor and assignment operator
     TopazNetwork(const TopazNetwork& obj);
@@ -193,6 +302,38 @@ class TopazNetwork : public Network
     //Statistical variables
     Stats::Formula m_msg_counts[MessageSizeType_NUM];
     Stats::Formula m_msg_bytes[MessageSizeType_NUM];
+    Stats::Scalar m_delivery_node_visits;
+    Stats::Scalar m_delivered_packets;
+    Stats::Formula m_node_visits_per_delivery;
+    Stats::Scalar m_msg_clones;
+    Stats::Scalar m_msg_clones_avoided;
+    Stats::Scalar m_envelope_allocations;
+    Stats::Scalar m_envelope_reuses;
+    Stats::Average m_envelope_occupancy;
+    Stats::Scalar m_envelope_high_water;
+    Stats::Scalar m_cycles_in_ruby;
+    Stats::Scalar m_cycles_in_topaz;
+    Stats::Scalar m_backend_switches;
+    Stats::Scalar m_topaz_steps;
+    Stats::Scalar m_topaz_host_seconds;
+    Stats::Formula m_host_seconds_per_step;
+
+    // Traffic carried by TOPAZ, measured at its boundary with Ruby
+    Stats::Vector m_flits_injected;
+    Stats::Vector m_flits_received;
+    Stats::Vector m_packets_received;
+    Stats::Vector m_network_latency;
+    // wait in the bridge input buffers only, summed per delivered packet
+    // like m_network_latency
+    Stats::Vector m_queueing_latency;
+    Stats::Vector m_hops;
+    Stats::Formula m_avg_vnet_latency;
+    Stats::Formula m_avg_vqueue_latency;
+    Stats::Formula m_avg_vnet_hops;
+    std::vector<Stats::Histogram *> m_network_latency_hist;
+    std::vector<Stats::Histogram *> m_hops_hist;
+    Stats::Vector m_router_flits_received;
+    Stats::Vector m_router_flits_per_cycle;
 };
 
 inline std::ostream&
@@ -53,6 +53,34 @@ class TopazNetwork(RubyNetwork):
                       "memory-network clock multiplier");
     topaz_adaptive_interface_threshold = Param.Int(0,
                       "infligh patckets required to activate TOPAZ");
+    topaz_hybrid_low_watermark = Param.Int(0,
+                      "in-flight messages below which traffic goes back to "
+                      "the Ruby network; 0 means the high watermark");
+    topaz_hybrid_high_watermark = Param.Int(0,
+                      "in-flight messages at which traffic moves to TOPAZ; "
+                      "0 means topaz_adaptive_interface_threshold");
+    topaz_hybrid_min_dwell = Param.Cycles(1000,
+                      "minimum cycles spent in a network before switching");
+    topaz_worker_threads = Param.Unsigned(0,
+                      "host threads, the simulating one included, running "
+                      "the per-vnet TOPAZ simulations side by side when "
+                      "they are not unified and the engine allows it "
+                      "(USE_TOPAZ=Reference); 0 or 1 disables")
+    topaz_vnets = VectorParam.Int([],
+                      "vnets modeled by TOPAZ, the others always go through "
+                      "the Ruby switches; empty means every vnet")
+    topaz_sampling = Param.Bool(False,
+                      "alternate detailed TOPAZ windows with windows where "
+                      "messages take a latency learned in the detailed ones")
+    topaz_sample_detailed_window = Param.Cycles(10000,
+                      "cycles simulated by TOPAZ in each sampling period")
+    topaz_sample_fast_window = Param.Cycles(90000,
+                      "cycles using drawn latencies in each sampling period")
+    topaz_sample_load_buckets = Param.Unsigned(4,
+                      "load levels (in-flight messages per router) with a "
+                      "latency distribution of their own")
+    topaz_sample_confidence = Param.Float(0.95,
+                      "confidence level of the reported latency interval")
 
 class TopazSwitch(BasicRouter):
       type = 'TopazSwitch'
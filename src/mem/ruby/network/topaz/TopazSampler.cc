@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2026 The University of Cantabria (Spain)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+#include "base/random.hh"
+#include "mem/ruby/network/topaz/TopazSampler.hh"
+
+using namespace std;
+
+TopazSampler::TopazSampler(int routers, int vnets, int load_buckets,
+                           Cycles detailed_window, Cycles fast_window,
+                           double confidence)
+    : m_routers(routers), m_vnets(vnets), m_load_buckets(load_buckets),
+      m_detailed_window(detailed_window),
+      m_period(detailed_window + fast_window), m_next_order(0),
+      m_in_flight(0), m_vnet_in_flight(vnets, 0), m_window(0),
+      m_window_latency(0), m_window_packets(0), m_windows(0),
+      m_window_sum(0), m_window_squares(0)
+{
+    assert(m_load_buckets > 0);
+    assert(m_period > 0);
+    assert(confidence > 0 && confidence < 1);
+
+    // z such that a normal variable is within +-z with the given
+    // probability, found by bisection on erf
+    double low = 0;
+    double high = 10;
+    for (int i = 0; i < 64; i++) {
+        double middle = (low + high) / 2;
+        if (erf(middle / sqrt(2.0)) < confidence)
+            low = middle;
+        else
+            high = middle;
+    }
+    m_z = (low + high) / 2;
+
+    m_reset_callback =
+        new MakeCallback<TopazSampler, &TopazSampler::resetWindows>(this);
+    Stats::registerResetCallback(m_reset_callback);
+}
+
+TopazSampler::~TopazSampler()
+{
+    delete m_reset_callback;
+}
+
+uint64_t
+TopazSampler::pairKey(SwitchID source, SwitchID dest, int vnet) const
+{
+    return ((uint64_t)source * m_routers + dest) * m_vnets + vnet;
+}
+
+uint64_t
+TopazSampler::hopKey(int hops, int vnet) const
+{
+    return (uint64_t)hops * m_vnets + vnet;
+}
+
+int
+TopazSampler::getLoadBucket(int in_flight) const
+{
+    return min(in_flight / m_routers, m_load_buckets - 1);
+}
+
+void
+TopazSampler::updateWindow(Cycles now)
+{
+    uint64_t window = now / m_period;
+    if (window == m_window)
+        return;
+    if (m_window_packets > 0) {
+        double mean = m_window_latency / m_window_packets;
+        m_windows++;
+        m_window_sum += mean;
+        m_window_squares += mean * mean;
+        m_detailed_windows++;
+    }
+    m_window = window;
+    m_window_latency = 0;
+    m_window_packets = 0;
+}
+
+bool
+TopazSampler::inFastWindow(Cycles now)
+{
+    updateWindow(now);
+    return now % m_period >= m_detailed_window;
+}
+
+void
+TopazSampler::addSample(Reservoir& reservoir, Cycles latency)
+{
+    reservoir.m_seen++;
+    if (reservoir.m_samples.size() < RESERVOIR_SIZE) {
+        reservoir.m_samples.push_back(latency);
+        return;
+    }
+    uint64_t slot = random_mt.random<uint64_t>(0, reservoir.m_seen - 1);
+    if (slot < RESERVOIR_SIZE)
+        reservoir.m_samples[slot] = latency;
+}
+
+void
+TopazSampler::recordLatency(SwitchID source, SwitchID dest, int vnet,
+                            int load_bucket, int hops, Cycles latency,
+                            Cycles now)
+{
+    updateWindow(now);
+    m_window_latency += latency;
+    m_window_packets++;
+
+    uint64_t key = pairKey(source, dest, vnet) * m_load_buckets;
+    addSample(m_pair_latencies[key + load_bucket], latency);
+    if (hops >= 0) {
+        key = hopKey(hops, vnet) * m_load_buckets;
+        addSample(m_hop_latencies[key + load_bucket], latency);
+    }
+}
+
+//******************************************************************************
+// Draws from the distribution of the closest load bucket that has samples
+//******************************************************************************
+bool
+TopazSampler::drawNearest(const ReservoirMap& map, uint64_t key,
+                          int load_bucket, Cycles& latency)
+{
+    key *= m_load_buckets;
+    for (int distance = 0; distance < m_load_buckets; distance++) {
+        for (int sign = -1; sign <= 1; sign += 2) {
+            int bucket = load_bucket + sign * distance;
+            if (bucket < 0 || bucket >= m_load_buckets)
+                continue;
+            ReservoirMap::const_iterator it = map.find(key + bucket);
+            if (it != map.end() && !it->second.m_samples.empty()) {
+                const vector<Cycles>& samples = it->second.m_samples;
+                latency = samples[random_mt.random<size_t>(
+                                          0, samples.size() - 1)];
+                return true;
+            }
+            if (distance == 0)
+                break;
+        }
+    }
+    return false;
+}
+
+Cycles
+TopazSampler::drawLatency(SwitchID source, SwitchID dest, int vnet,
+                          int load_bucket, int hops, Cycles zero_load)
+{
+    Cycles latency;
+    if (!drawNearest(m_pair_latencies, pairKey(source, dest, vnet),
+                     load_bucket, latency)) {
+        m_fallback_draws++;
+        if (hops < 0 || !drawNearest(m_hop_latencies, hopKey(hops, vnet),
+                                     load_bucket, latency))
+            latency = zero_load;
+    }
+    latency = max(latency, Cycles(1));
+    m_sampled_packets++;
+    m_sampled_latency += latency;
+    return latency;
+}
+
+void
+TopazSampler::schedule(MessageTopaz* envelope, SwitchID router, Cycles due,
+                       bool ordered)
+{
+    if (ordered) {
+        // no overtaking between the same pair of routers
+        Cycles& last = m_last_due[pairKey(envelope->source, router,
+                                          envelope->vnet)];
+        if (due < last)
+            due = last;
+        last = due;
+    }
+    Pending pending;
+    pending.m_due = due;
+    pending.m_order = m_next_order++;
+    pending.m_delivery.m_router = router;
+    pending.m_delivery.m_message = envelope;
+    m_pending.push_back(pending);
+    push_heap(m_pending.begin(), m_pending.end(), greater<Pending>());
+}
+
+void
+TopazSampler::collect(Cycles now, vector<TopazDelivery>& delivered)
+{
+    while (!m_pending.empty() && m_pending.front().m_due <= now) {
+        delivered.push_back(m_pending.front().m_delivery);
+        pop_heap(m_pending.begin(), m_pending.end(), greater<Pending>());
+        m_pending.pop_back();
+    }
+}
+
+void
+TopazSampler::decreaseInFlight(int vnet)
+{
+    m_in_flight--;
+    m_vnet_in_flight[vnet]--;
+    assert(m_vnet_in_flight[vnet] >= 0);
+}
+
+void
+TopazSampler::resetWindows()
+{
+    m_windows = 0;
+    m_window_sum = 0;
+    m_window_squares = 0;
+    m_window_latency = 0;
+    m_window_packets = 0;
+}
+
+void
+TopazSampler::regStats(const string& name)
+{
+    m_sampled_packets
+        .name(name + ".sampling_fast_packets")
+        .flags(Stats::nozero)
+        ;
+    m_sampled_latency
+        .name(name + ".sampling_fast_latency")
+        .flags(Stats::nozero)
+        ;
+    m_avg_sampled_latency
+        .name(name + ".sampling_average_fast_latency")
+        .flags(Stats::nozero)
+        ;
+    m_avg_sampled_latency = m_sampled_latency / m_sampled_packets;
+    m_fallback_draws
+        .name(name + ".sampling_fallback_draws")
+        .flags(Stats::nozero)
+        ;
+    m_detailed_windows
+        .name(name + ".sampling_detailed_windows")
+        .flags(Stats::nozero)
+        ;
+    m_window_latency_mean
+        .name(name + ".sampling_latency_mean")
+        .flags(Stats::nozero)
+        ;
+    m_window_latency_ci
+        .name(name + ".sampling_latency_ci")
+        .flags(Stats::nozero)
+        ;
+    m_window_latency_relative_ci
+        .name(name + ".sampling_latency_relative_ci")
+        .flags(Stats::nozero)
+        ;
+}
+
+//******************************************************************************
+// Each detailed window is one sample of the mean latency, so the interval
+// is mean +- z * s / sqrt(windows)
+//******************************************************************************
+void
+TopazSampler::collateStats()
+{
+    if (m_windows == 0)
+        return;
+    double mean = m_window_sum / m_windows;
+    m_window_latency_mean = mean;
+    if (m_windows < 2)
+        return;
+    double variance = (m_window_squares - m_windows * mean * mean) /
+                      (m_windows - 1);
+    double ci = m_z * sqrt(max(variance, 0.0) / m_windows);
+    m_window_latency_ci = ci;
+    if (mean > 0)
+        m_window_latency_relative_ci = ci / mean;
+}
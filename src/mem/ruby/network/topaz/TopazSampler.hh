@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2026 The University of Cantabria (Spain)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Sampled TOPAZ mode. Time is split in periods made of a detailed window,
+ * where messages go through TOPAZ, followed by a fast window, where each
+ * message takes a latency drawn from what TOPAZ showed in the detailed
+ * windows for the same source router, destination router, vnet and load.
+ * Load is the number of messages in flight when the message was injected,
+ * quantized in buckets of one message per router.
+ *
+ * Every detailed window gives one sample of the mean network latency. The
+ * mean of these samples and its confidence interval tell how far off the
+ * sampled run may be from a detailed one.
+ */
+
+#ifndef __MEM_RUBY_NETWORK_TOPAZ_TOPAZSAMPLER_HH__
+#define __MEM_RUBY_NETWORK_TOPAZ_TOPAZSAMPLER_HH__
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "base/callback.hh"
+#include "base/statistics.hh"
+#include "base/types.hh"
+#include "mem/ruby/common/TypeDefines.hh"
+#include "mem/ruby/network/topaz/TopazNetwork.hh"
+
+class TopazSampler
+{
+  public:
+    // latencies kept per distribution, older ones are replaced at random
+    static const int RESERVOIR_SIZE = 32;
+
+    TopazSampler(int routers, int vnets, int load_buckets,
+                 Cycles detailed_window, Cycles fast_window,
+                 double confidence);
+    ~TopazSampler();
+
+    // true while messages take a drawn latency instead of TOPAZ
+    bool inFastWindow(Cycles now);
+    int getLoadBucket(int in_flight) const;
+
+    // latency a message injected in TOPAZ took
+    void recordLatency(SwitchID source, SwitchID dest, int vnet,
+                       int load_bucket, int hops, Cycles latency,
+                       Cycles now);
+    Cycles drawLatency(SwitchID source, SwitchID dest, int vnet,
+                       int load_bucket, int hops, Cycles zero_load);
+    void schedule(MessageTopaz* envelope, SwitchID router, Cycles due,
+                  bool ordered);
+    void collect(Cycles now, std::vector<TopazDelivery>& delivered);
+    bool hasPending() const { return !m_pending.empty(); }
+    // earliest due cycle, only meaningful when hasPending()
+    Cycles getNextDue() const { return m_pending.front().m_due; }
+
+    // message destinations waiting for their drawn latency to elapse
+    void increaseInFlight(int vnet, int num)
+    { m_in_flight += num; m_vnet_in_flight[vnet] += num; }
+    void decreaseInFlight(int vnet);
+    int getInFlight() const { return m_in_flight; }
+    int getInFlight(int vnet) const { return m_vnet_in_flight[vnet]; }
+
+    void regStats(const std::string& name);
+    void collateStats();
+
+  private:
+    struct Reservoir
+    {
+        Reservoir() : m_seen(0) {}
+        std::vector<Cycles> m_samples;
+        uint64_t m_seen;
+    };
+
+    struct Pending
+    {
+        Cycles m_due;
+        uint64_t m_order;
+        TopazDelivery m_delivery;
+
+        bool
+        operator>(const Pending& other) const
+        {
+            if (m_due != other.m_due)
+                return m_due > other.m_due;
+            return m_order > other.m_order;
+        }
+    };
+
+    typedef std::unordered_map<uint64_t, Reservoir> ReservoirMap;
+
+    // Private copy constructor and assignment operator
+    TopazSampler(const TopazSampler& obj);
+    TopazSampler& operator=(const TopazSampler& obj);
+
+    uint64_t pairKey(SwitchID source, SwitchID dest, int vnet) const;
+    uint64_t hopKey(int hops, int vnet) const;
+    void addSample(Reservoir& reservoir, Cycles latency);
+    bool drawNearest(const ReservoirMap& map, uint64_t key, int load_bucket,
+                     Cycles& latency);
+    void updateWindow(Cycles now);
+    void resetWindows();
+
+    int m_routers;
+    int m_vnets;
+    int m_load_buckets;
+    Cycles m_detailed_window;
+    Cycles m_period;
+    // two-sided normal quantile of the requested confidence
+    double m_z;
+
+    // by source, destination and vnet, and pooled by hops and vnet for
+    // pairs not seen yet
+    ReservoirMap m_pair_latencies;
+    ReservoirMap m_hop_latencies;
+
+    // deliveries ordered by due cycle, then by injection
+    std::vector<Pending> m_pending;
+    uint64_t m_next_order;
+    // last due cycle per source, destination and ordered vnet
+    std::unordered_map<uint64_t, Cycles> m_last_due;
+    int m_in_flight;
+    std::vector<int> m_vnet_in_flight;
+
+    // mean latency of the detailed window in progress
+    uint64_t m_window;
+    double m_window_latency;
+    int m_window_packets;
+    // one sample per finished detailed window
+    int m_windows;
+    double m_window_sum;
+    double m_window_squares;
+    Callback* m_reset_callback;
+
+    Stats::Scalar m_sampled_packets;
+    Stats::Scalar m_sampled_latency;
+    Stats::Formula m_avg_sampled_latency;
+    Stats::Scalar m_fallback_draws;
+    Stats::Scalar m_detailed_windows;
+    Stats::Scalar m_window_latency_mean;
+    Stats::Scalar m_window_latency_ci;
+    Stats::Scalar m_window_latency_relative_ci;
+};
+
+#endif // __MEM_RUBY_NETWORK_TOPAZ_TOPAZSAMPLER_HH__
@@ -65,9 +65,9 @@ TopazSwitch::init()
 }
 
 void
-TopazSwitch::addInPort(const vector<MessageBuffer*>& in)
+TopazSwitch::addInPort(const vector<MessageBuffer*>& in, bool endpoint)
 {
-    m_perfect_switch_ptr->addInPort(in);
+    m_perfect_switch_ptr->addInPort(in, endpoint);
 
     for (auto& it : in) {
         if (it != nullptr) {
@@ -79,7 +79,8 @@ TopazSwitch::addInPort(const vector<MessageBuffer*>& in)
 void
 TopazSwitch::addOutPort(const vector<MessageBuffer*>& out,
                    const NetDest& routing_table_entry,
-                   Cycles link_latency, int bw_multiplier)
+                   Cycles link_latency, int bw_multiplier,
+                   bool endpoint)
 {
     // Create a throttle
     Throttle* throttle_ptr = new Throttle(m_id, m_throttles.size(),
@@ -112,12 +113,25 @@ TopazSwitch::addOutPort(const vector<MessageBuffer*>& out,
     }
 
     // Hook the queues to the PerfectSwitch
-    m_perfect_switch_ptr->addOutPort(intermediateBuffers, routing_table_entry);
+    m_perfect_switch_ptr->addOutPort(intermediateBuffers, routing_table_entry,
+                                     endpoint);
 
     // Hook the queues to the Throttle
     throttle_ptr->addLinks(intermediateBuffers, out);
 }
 
+bool
+TopazSwitch::hasPendingEjections(int vnet) const
+{
+    return m_perfect_switch_ptr->hasPendingEjections(vnet);
+}
+
+bool
+TopazSwitch::hasPendingInjections() const
+{
+    return m_perfect_switch_ptr->hasPendingInjections();
+}
+
 const Throttle*
 TopazSwitch::getThrottle(LinkID link_number) const
 {
@@ -63,10 +63,14 @@ class TopazSwitch : public BasicRouter
     ~TopazSwitch();
 
     void init();
-    void addInPort(const std::vector<MessageBuffer*>& in);
+    void addInPort(const std::vector<MessageBuffer*>& in,
+                   bool endpoint = false);
     void addOutPort(const std::vector<MessageBuffer*>& out,
                 const NetDest& routing_table_entry,
-                Cycles link_latency, int bw_multiplier);
+                Cycles link_latency, int bw_multiplier,
+                bool endpoint = false);
+    bool hasPendingEjections(int vnet) const;
+    bool hasPendingInjections() const;
 
     const Throttle* getThrottle(LinkID link_number) const;
     const std::vector<Throttle*>* getThrottles() const;
@@ -30,10 +30,12 @@
 
 #include <TPZSimulator.hpp>
 
+#include "base/bitfield.hh"
 #include "base/cast.hh"
 #include "base/random.hh"
 #include "debug/RubyNetwork.hh"
 #include "mem/ruby/network/MessageBuffer.hh"
+#include "mem/ruby/network/topaz/TopazMulticastMask.hh"
 #include "mem/ruby/network/topaz/TopazNetwork.hh"
 #include "mem/ruby/network/topaz/TopazSwitchFlow.hh"
 #include "mem/ruby/network/topaz/TopazSwitch.hh"
@@ -45,14 +47,6 @@ using namespace std;
 
 const int PRIORITY_SWITCH_LIMIT = 128;
 
-//xA VPV KEEP COMMENTED!
-// Operator for helper class
-//bool
-//operator<(const LinkOrder& l1, const LinkOrder& l2)
-//{
-//    return (l1.m_value < l2.m_value);
-//}
-
 //TopazSwitchFlow::TopazSwitchFlow(SwitchID sid, TopazNetwork* network_ptr)
 TopazSwitchFlow::TopazSwitchFlow(SwitchID sid, TopazSwitch *sw, uint32_t virt_nets)
     : Consumer(sw)
@@ -60,7 +54,6 @@ TopazSwitchFlow::TopazSwitchFlow(SwitchID sid, TopazSwitch *sw, uint32_t virt_ne
     m_switch_id = sid;
     m_round_robin_start = 0;
     m_wakeups_wo_switch = 0;
-    m_ruby_start=0;
     m_virtual_networks = virt_nets;
 }
 
@@ -68,6 +61,7 @@ void
 TopazSwitchFlow::init(TopazNetwork *network_ptr)
 {
     m_network_ptr = network_ptr;
+    m_multicast_routers.setSize(m_network_ptr->getNetSize());
 
     for(int i = 0;i < m_virtual_networks;++i) {
         m_pending_message_count.push_back(0);
@@ -75,10 +69,11 @@ TopazSwitchFlow::init(TopazNetwork *network_ptr)
 }
 
 void
-TopazSwitchFlow::addInPort(const vector<MessageBuffer*>& in)
+TopazSwitchFlow::addInPort(const vector<MessageBuffer*>& in, bool endpoint)
 {
     NodeID port = m_in.size();
     m_in.push_back(in);
+    m_endpoint_in.push_back(endpoint);
 
     for (int i = 0; i < in.size(); ++i) {
         if (in[i] != nullptr) {
@@ -98,17 +93,39 @@ TopazSwitchFlow::addInPort(const vector<MessageBuffer*>& in)
 
 void
 TopazSwitchFlow::addOutPort(const vector<MessageBuffer*>& out,
-                            const NetDest& routing_table_entry)
+                            const NetDest& routing_table_entry,
+                            bool endpoint)
 {
-    // Setup link order
-    LinkOrder l;
-    l.m_value = 0;
-    l.m_link = m_out.size();
-    m_link_order.push_back(l);
+    m_link_value.push_back(0);
 
     // Add to routing table
     m_out.push_back(out);
-    m_routing_table.push_back(routing_table_entry);
+    m_endpoint_out.push_back(endpoint);
+    m_routing_table.addLink(routing_table_entry);
+}
+
+//******************************************************************************
+// Ruby messages already routed to an ejection link but still waiting in
+// its throttle
+//******************************************************************************
+bool
+TopazSwitchFlow::hasPendingEjections(int vnet) const
+{
+    for (int i = 0; i < m_out.size(); i++) {
+        if (m_endpoint_out[i] && !m_out[i][vnet]->isEmpty())
+            return true;
+    }
+    return false;
+}
+
+bool
+TopazSwitchFlow::hasPendingInjections() const
+{
+    for (int vnet = 0; vnet < m_pending_message_count.size(); vnet++) {
+        if (m_pending_message_count[vnet] > 0)
+            return true;
+    }
+    return false;
 }
 
 TopazSwitchFlow::~TopazSwitchFlow()
@@ -118,85 +135,171 @@ TopazSwitchFlow::~TopazSwitchFlow()
 //******************************************************************************
 // Function in charge of calculating the destination of an Unicast message
 //******************************************************************************
-int TopazSwitchFlow::getUnicastDestination(NetDest destinations) {
-    int this_id;
-    int m_queue=0;
-    for (MachineType mType = MachineType_FIRST; mType < MachineType_NUM; ++mType) {
-        int limit = MachineType_base_count(mType);
-        for (unsigned int component = 0; component < limit; component++) {
-            MachineID mach = {mType, component};
-            if (destinations.elementAt(mach)==1) {
-                this_id=m_network_ptr->getSwitch(m_queue+component);
-                return this_id;
-            }
-        }
-        m_queue += MachineType_base_count(mType);
+int TopazSwitchFlow::getUnicastDestination(const vector<NodeID>& nodes) {
+    assert(nodes.size() == 1);
+    return m_network_ptr->getSwitch(nodes[0]);
+}
+
+//******************************************************************************
+// Function in charge of calculating the router mask of a Multicast message
+//******************************************************************************
+void
+TopazSwitchFlow::getMulticastDestination(const vector<NodeID>& nodes,
+                                         TopazMulticastMask& routers) {
+    for (int i = 0; i < nodes.size(); i++) {
+        routers.add(m_network_ptr->getSwitch(nodes[i]));
     }
-    assert(m_queue!=0);
-    return 1;
 }
 
 //******************************************************************************
-// Function in charge of calculating the mask of a Multicast message
+// Multicast to routers beyond the first 64. Engines that take a mask of
+// any width (TPZ_WIDE_MSGMASK, e.g. the reference engine) get the whole
+// router set as a single multicast. The external TOPAZ only carries a
+// 64-bit mask, so there the routers that do not fit in it are reached
+// with one unicast packet each, all of them sharing the same MessageTopaz,
+// and only the first 64 routers travel as a TOPAZ multicast.
 //******************************************************************************
-unsigned long long
-TopazSwitchFlow::getMulticastDestination(NetDest& destinations) {
-    unsigned long long routers = 0;
-    int node_number = 0;
-    for (MachineType m = MachineType_FIRST; m < MachineType_NUM; ++m) {
-        for (unsigned int c = 0; c<MachineType_base_count(m); c++) {
-            MachineID thisMid = {m, c};
-            if (destinations.isElement(thisMid)) {
-                unsigned long long mask = 1;
-                mask = mask << (m_network_ptr->getSwitch(node_number));
-                routers = routers | mask;
-            }
-            node_number++;
-        }
+void
+TopazSwitchFlow::sendWideMulticast(int vnet, TPZMessage& msg,
+                                   const TopazMulticastMask& routers) {
+#ifdef TPZ_WIDE_MSGMASK
+    for (int word = 0; word < routers.getNumWords(); word++)
+        msg.setMsgmaskWord(word, routers.getWord(word));
+    m_network_ptr->sendTopazMessage(vnet, msg);
+#else
+    TPZNetwork* network = TPZSIMULATOR()->getSimulation(1)->getNetwork();
+    for (SwitchID router =
+             routers.nextElement(TopazMulticastMask::WORD_BITS);
+         router < routers.getSize();
+         router = routers.nextElement(router + 1)) {
+        TPZMessage unicast = msg;
+        unicast.clearMulticast();
+        unicast.setDestiny(network->CreatePosition(router));
+        m_network_ptr->sendTopazMessage(vnet, unicast);
+    }
+
+    uint64 first_word = routers.getWord(0);
+    if (first_word == 0)
+        return;
+    if (popCount(first_word) == 1) {
+        msg.clearMulticast();
+        msg.setDestiny(network->CreatePosition(findLsbSet(first_word)));
+    } else {
+        msg.setMsgmask(first_word);
     }
-    return routers;
+    m_network_ptr->sendTopazMessage(vnet, msg);
+#endif
 }
 
 //******************************************************************************
-// Function in charge of filtering messages with src=dst
-// this kind of messages are not routed through TOPAZ network
+// Builds the TOPAZ packet of a message bound to the routers of m_dest_nodes
+// and hands it to TOPAZ
 //******************************************************************************
 void
-TopazSwitchFlow::filterZeroDistanceMessages( MsgPtr& msg_ptr, int vnet,
-                                                NetDest& destinations) {
+TopazSwitchFlow::injectTopazMessage(MessageTopaz* copia) {
+    int vnet=copia->vnet;
     int source=m_switch_id;
-    int destination;
-    bool isOrdered= m_network_ptr->isVNetOrdered(vnet);
-    int m_queue=0;
-    for (MachineType mType = MachineType_FIRST; mType < MachineType_NUM; ++mType){
-        int limit = MachineType_base_count(mType);
-        for (unsigned int component = 0; component < limit; component++)    {
-            MachineID mach = {mType, component};
-            if(destinations.elementAt(mach)==1)    {
-                destination=m_network_ptr->getSwitch(m_queue+component);
-                if (source == destination){
-                    MessageBuffer* outputQueue=m_network_ptr->
-                          getFromSimNetQueue(component+m_queue, isOrdered, vnet);
-                    MsgPtr unaMas=msg_ptr->clone();
-                    outputQueue->enqueue(unaMas);
-                    destinations.remove(mach); // Here destinations are modified
-                }
-            }
+    int topaz_size=copia->flits;
+    int num_destinations=copia->destinations;
+    TPZMessage msg;
+    TPZPosition origen;
+    TPZPosition destino;
+    bool wide_multicast = false;
+    // TOPAZ message generation
+    msg.setExternalInfo(static_cast<void*>(copia));
+    msg.setGenerationTime(m_network_ptr->getTopazTime());
+    origen=TPZSIMULATOR()->getSimulation(1)->
+                          getNetwork()->CreatePosition(source);
+    msg.setSource(origen);
+    msg.setVnet(vnet+1);
+    msg.setMessageSize(1);
+    msg.setPacketSize(topaz_size);
+    if (m_network_ptr->isVNetOrdered(vnet)){
+        msg.setOrdered();
+    }
+    if (num_destinations==1) {
+        msg.clearMulticast();
+        int componente = getUnicastDestination(m_dest_nodes);
+        destino=TPZSIMULATOR()->getSimulation(1)->
+                getNetwork()->CreatePosition(componente);
+        msg.setDestiny(destino);
+        m_network_ptr->notifyInjection(vnet, componente);
+    }
+    else {
+        msg.setMulticast();
+        //This destination is necessary because topaz
+        //checks the existence
+        //of src and destination routers
+        //this destination is only used for this purpose,
+        //no messages will arrive to it.
+        msg.setDestiny(origen);
+        m_multicast_routers.clear();
+        getMulticastDestination(m_dest_nodes,
+                                m_multicast_routers);
+        if (m_multicast_routers.fitsInFirstWord()) {
+            msg.setMsgmask(m_multicast_routers.getWord(0));
+        } else {
+            wide_multicast = true;
         }
-        m_queue += MachineType_base_count(mType);
+        // every router in the set receives exactly one packet
+        for (SwitchID router = m_multicast_routers.nextElement(0);
+             router < m_multicast_routers.getSize();
+             router = m_multicast_routers.nextElement(router + 1)) {
+            m_network_ptr->notifyInjection(vnet, router);
+        }
+    }
+    // Send the message to the network
+    DPRINTF(RubyNetwork, "Send at switch: [%d] vnet: [%d] time: [%d].\n",
+                          m_switch_id, vnet, g_system_ptr->curCycle());
+    if (wide_multicast) {
+        sendWideMulticast(vnet, msg, m_multicast_routers);
+    } else {
+        m_network_ptr->sendTopazMessage(vnet, msg);
     }
 }
 
 //******************************************************************************
-// This function returns a NetDest vector result of the following operation
-//  msg_destinations & Router_mask
-// where Router_mask indicates which components are reachable through a certain
-// switch
+// Fast window of the sampled mode: the message skips TOPAZ and reaches each
+// destination router after a latency drawn from the detailed windows
 //******************************************************************************
-NetDest
-TopazSwitchFlow::getConsumerDestinations(int switch_id, NetDest& dest) {
-    NetDest consumers = m_network_ptr->getMachines(switch_id);
-    return consumers.AND(dest);
+void
+TopazSwitchFlow::injectSampledMessage(MessageTopaz* copia) {
+    m_multicast_routers.clear();
+    getMulticastDestination(m_dest_nodes, m_multicast_routers);
+    for (SwitchID router = m_multicast_routers.nextElement(0);
+         router < m_multicast_routers.getSize();
+         router = m_multicast_routers.nextElement(router + 1)) {
+        m_network_ptr->sendSampledMessage(copia, router);
+    }
+    DPRINTF(RubyNetwork, "Sampled at switch: [%d] vnet: [%d] time: [%d].\n",
+                          m_switch_id, copia->vnet, g_system_ptr->curCycle());
+}
+
+//******************************************************************************
+// Function in charge of filtering messages with src=dst
+// this kind of messages are not routed through TOPAZ network. When every
+// destination is local the last one takes msg_ptr itself, so it must have
+// been dequeued already
+//******************************************************************************
+void
+TopazSwitchFlow::filterZeroDistanceMessages( MsgPtr& msg_ptr, int vnet,
+                                             vector<NodeID>& nodes) {
+    int source=m_switch_id;
+    bool isOrdered= m_network_ptr->isVNetOrdered(vnet);
+    int remote = 0;
+    for (int i = 0; i < nodes.size(); i++) {
+        NodeID node = nodes[i];
+        if (m_network_ptr->getSwitch(node) != source) {
+            nodes[remote++] = node;
+            continue;
+        }
+        MessageBuffer* outputQueue=m_network_ptr->
+              getFromSimNetQueue(node, isOrdered, vnet);
+        bool last = remote == 0 && i == nodes.size() - 1;
+        MsgPtr unaMas=m_network_ptr->messageForDestination(msg_ptr, last);
+        outputQueue->enqueue(unaMas);
+    }
+    nodes.resize(remote); // Here destinations are modified
 }
 
 //******************************************************************************
@@ -221,9 +324,15 @@ void TopazSwitchFlow::wakeup() {
   for (int vnet = highest_prio_vnet;
      (vnet * decrementer) >= (decrementer * lowest_prio_vnet);
      vnet -= decrementer) {
+       //An ordered vnet changing network keeps its components waiting
+       //until the old one is empty, only Ruby's in-flight messages move
+        if (m_network_ptr->isVNetDraining(vnet)) {
+           wakeupVnet(vnet, false);
+           scheduleEvent(Cycles(1));
+        }
        //If we are in warmup or the adaptive interface is used and then
        //network is lightly loadad we may ruby network
-        if (m_network_ptr->useGemsNetwork(vnet)) {
+        else if (m_network_ptr->useGemsNetwork(vnet)) {
            wakeupVnet(vnet);
         }
      //Otherwise, use topaz
@@ -254,145 +363,58 @@ void TopazSwitchFlow::wakeup() {
             //If there is packets waiting, we move it to Topaz
             while(buffer->isReady()){
                 MsgPtr msg_ptr = buffer->peekMsgPtr();
+                // Dequeue before the message is handed to a local queue or
+                // an envelope, both of which own it from then on. Until the
+                // message was shared among its destinations it was cloned,
+                // and the dequeue came after the send.
+                buffer->dequeue();
+                m_pending_message_count[vnet]--;
                 NetworkMessage *net_msg_ptr =
                         dynamic_cast<NetworkMessage*>(msg_ptr.get());
-                NetDest msg_destinations =
-                        net_msg_ptr->getInternalDestination();
+                m_dest_nodes.clear();
+                net_msg_ptr->getInternalDestination().getAllDest(m_dest_nodes);
+                // left behind in a Ruby switch by the move to TOPAZ
+                if (!m_endpoint_in[incoming])
+                    m_network_ptr->decreaseNumMsg(vnet, m_dest_nodes.size());
                 int topaz_size=m_network_ptr->
                         getMessageSizeTopaz(net_msg_ptr->getMessageSize());
                 assert(topaz_size);
-                filterZeroDistanceMessages( msg_ptr, vnet, msg_destinations);
-                if ( msg_destinations.count() !=0) {
-                    TPZMessage msg;
-                    TPZPosition origen;
-                    TPZPosition destino;
-                    MessageTopaz* copia=new  MessageTopaz;
-                    copia->message=msg_ptr->clone();
+                filterZeroDistanceMessages( msg_ptr, vnet, m_dest_nodes);
+                int num_destinations = m_dest_nodes.size();
+                if ( num_destinations !=0) {
+                    MessageTopaz* copia=m_network_ptr->allocateMessageTopaz();
+                    // The envelope takes over the dequeued message, it is
+                    // only copied again at destinations that need their own
+                    copia->message=msg_ptr;
+                    m_network_ptr->increaseClonesAvoided();
                     copia->vnet=vnet;
-                    copia->destinations=msg_destinations.count();
-                    // TOPAZ message generation
-                    msg.setExternalInfo(static_cast<void*>(copia));
-                    msg.setGenerationTime(TPZSIMULATOR()->
-                                          getSimulation(1)->getCurrentTime());
-                    origen=TPZSIMULATOR()->getSimulation(1)->
-                                          getNetwork()->CreatePosition(source);
-                    msg.setSource(origen);
-                    msg.setVnet(vnet+1);
-                    msg.setMessageSize(1);
-                    msg.setPacketSize(topaz_size);
-                    if (m_network_ptr->isVNetOrdered(vnet)){
-                        msg.setOrdered();
-                        m_network_ptr->
-                               increaseNumTopazOrderedMsg(msg_destinations.count());
-                    }
-                    if (msg_destinations.count()==1) {
-                        msg.clearMulticast();
-                        int componente = getUnicastDestination(msg_destinations);
-                        destino=TPZSIMULATOR()->getSimulation(1)->
-                                getNetwork()->CreatePosition(componente);
-                        msg.setDestiny(destino);
-                    }
-                    else {
-                        msg.setMulticast();
-                        //This destination is necessary because topaz
-                        //checks the existence
-                        //of src and destination routers
-                        //this destination is only used for this purpose,
-                        //no messages will arrive to it.
-                        msg.setDestiny(origen);
-                        unsigned long long msgMask=
-                               getMulticastDestination(msg_destinations);
-                        msg.setMsgmask(msgMask);
-                    }
-                    // Send the message to the network
-                    DPRINTF(RubyNetwork, "Send at switch: [%d] vnet: [%d] time: [%d].\n",
-                                          m_switch_id, vnet, g_system_ptr->curCycle());
-                    TPZSIMULATOR()->getSimulation(1)->getNetwork()->sendMessage(msg);
-                    m_network_ptr->increaseNumTopazMsg(msg_destinations.count());
+                    copia->destinations=num_destinations;
+                    copia->source=source;
+                    copia->injection_time=g_system_ptr->curCycle();
+                    copia->flits=topaz_size;
+                    copia->queueing_latency=g_system_ptr->ticksToCycles(
+                        curTick() - msg_ptr->getLastEnqueueTime());
+                    m_network_ptr->recordInjection(vnet, topaz_size);
+                    copia->load_bucket=m_network_ptr->getLoadBucket();
+                    copia->sampled=m_network_ptr->useSampledPath(vnet);
+                    if (copia->sampled)
+                        injectSampledMessage(copia);
+                    else
+                        injectTopazMessage(copia);
+                    m_network_ptr->increaseNumTopazMsg(vnet, num_destinations,
+                                                       copia->sampled);
+                    m_network_ptr->activateTicker();
                 }
-                buffer->dequeue();
-                m_pending_message_count[vnet]--;
             }
           }
        }
     }
-    //ijust a prewarmed simulation
-    if (m_network_ptr->inWarmup()) return;
-    if (m_network_ptr->getTriggerSwitch() == ~0) {
-        m_network_ptr->setTriggerSwitch(m_switch_id);
-    }
-    //Only first switch  run and implement consumption.
-    if ( m_switch_id != m_network_ptr->getTriggerSwitch() ) return;
-    wakeUpTopaz();
+    // a delivery that stays local leaves no count behind to signal it
+    m_network_ptr->checkDrain();
 }
 
-//******************************************************************************
-// This function is in charge of running TOPAZ and collecting the messages
-// to send then back to GEMS queues
-//******************************************************************************
-void TopazSwitchFlow::wakeUpTopaz() {
-    long unsigned current_time =
-         static_cast<long unsigned>(g_system_ptr->curCycle()) - m_ruby_start;
-    int procesorNetRatio=m_network_ptr->getProcRouterRatio();
-    int messagesOnNets=0;
-    long diff_time = current_time - TPZSIMULATOR()->getSimulation(1)->getCurrentTime()*procesorNetRatio;
-    if (diff_time > 0) {
-        TPZSIMULATOR()->getSimulation(1)->setCurrentTime((current_time/procesorNetRatio)-1);
-        TPZSIMULATOR()->getSimulation(1)->run(1);
-        for (int consumer = 0;
-             consumer<TPZSIMULATOR()->getSimulation(1)->getNetwork()->Number_of_nodes();
-             consumer++) {
-             TPZPosition position_f=
-                 TPZSIMULATOR()->getSimulation(1)->getNetwork()->CreatePosition(consumer);
-            void* ptr =(TPZSIMULATOR()->getSimulation(1)->getExternalInfoAt(position_f));
-            if (ptr!=NULL) {
-                MessageTopaz* topaz_message = static_cast<MessageTopaz*>(ptr);
-                assert (topaz_message->destinations>0);
-                MsgPtr localCopy = (topaz_message->message);
-                NetworkMessage* net_msg_ptr =
-                                dynamic_cast<NetworkMessage*>(localCopy.get());
-                int vvnet=topaz_message->vnet;
-                int isOrdered= m_network_ptr->isVNetOrdered(vvnet);
-                NetDest ConsDestinations =
-                           getConsumerDestinations(consumer,
-                                          net_msg_ptr->getInternalDestination());
-                DPRINTF(RubyNetwork, "Arrival at switch: [%d] vnet: [%d] time: [%d].\n",
-                                      consumer, vvnet, g_system_ptr->curCycle());
-                int m_queue=0;
-                for (MachineType mType = MachineType_FIRST;
-                     mType < MachineType_NUM; ++mType) {
-                    int limit = MachineType_base_count(mType);
-                    for (unsigned int component = 0; component < limit; component++) {
-                        MachineID mach = {mType, component};
-                        if(ConsDestinations.elementAt(mach)==1) {
-                            MsgPtr unaMas = localCopy->clone();
-                            MessageBuffer* outputQueue=
-                                 m_network_ptr->getFromSimNetQueue(component+m_queue,
-                                                                   isOrdered,
-                                                                   vvnet);
-                            outputQueue->enqueue(unaMas);
-                            topaz_message->destinations=topaz_message->destinations-1;
-                            m_network_ptr->decreaseNumTopazMsg(vvnet);
-                        }
-                    }
-                    m_queue += MachineType_base_count(mType);
-                }
-                int pendientes=topaz_message->destinations;
-                if (pendientes==0) delete topaz_message;
-            }
-        }
-        messagesOnNets=m_network_ptr->getTopazMessages();
-    }
-
-    if ( messagesOnNets!=0)
-        scheduleEvent(Cycles(1));
-    else
-        m_network_ptr->setTriggerSwitch(~0);
-}
-
-
 void
-TopazSwitchFlow::wakeupVnet(int vnet)
+TopazSwitchFlow::wakeupVnet(int vnet, bool endpoints)
 {
     MsgPtr msg_ptr;
     NetworkMessage* net_msg_ptr = NULL;
@@ -422,6 +444,11 @@ TopazSwitchFlow::wakeupVnet(int vnet)
                 continue;
             }
 
+            // Components wait while their vnet drains
+            if (m_endpoint_in[incoming] && !endpoints) {
+                continue;
+            }
+
             MessageBuffer *buffer = m_in[incoming][vnet];
             if (buffer == nullptr) {
                 continue;
@@ -437,65 +464,35 @@ TopazSwitchFlow::wakeupVnet(int vnet)
 
                 output_links.clear();
                 output_link_destinations.clear();
-                NetDest msg_dsts = net_msg_ptr->getInternalDestination();
 
                 // Unfortunately, the token-protocol sends some
-                // zero-destination messages, so this assert isn't valid
-                // assert(msg_dsts.count() > 0);
-
-                assert(m_link_order.size() == m_routing_table.size());
-                assert(m_link_order.size() == m_out.size());
-
-                if (m_network_ptr->getAdaptiveRouting()) {
-                    if (m_network_ptr->isVNetOrdered(vnet)) {
-                        // Don't adaptively route
-                        for (int out = 0; out < m_out.size(); out++) {
-                            m_link_order[out].m_link = out;
-                            m_link_order[out].m_value = 0;
-                        }
-                    } else {
-                        // Find how clogged each link is
-                        for (int out = 0; out < m_out.size(); out++) {
-                            int out_queue_length = 0;
-                            for (int v = 0; v < m_virtual_networks; v++) {
-                                out_queue_length += m_out[out][v]->getSize();
-                            }
-                            int value =
-                                (out_queue_length << 8) |
-                                random_mt.random(0, 0xff);
-                            m_link_order[out].m_link = out;
-                            m_link_order[out].m_value = value;
+                // zero-destination messages, so no destinations (and no
+                // output links) is valid
+
+                assert(m_routing_table.getLinks() == m_out.size());
+
+                // Look at the most empty link first when routing
+                // adaptively, otherwise in link order
+                const vector<int>* link_value = NULL;
+                if (m_network_ptr->getAdaptiveRouting() &&
+                    !m_network_ptr->isVNetOrdered(vnet)) {
+                    // Find how clogged each link is
+                    for (int out = 0; out < m_out.size(); out++) {
+                        int out_queue_length = 0;
+                        for (int v = 0; v < m_virtual_networks; v++) {
+                            out_queue_length += m_out[out][v]->getSize();
                         }
-
-                        // Look at the most empty link first
-                        sort(m_link_order.begin(), m_link_order.end());
+                        m_link_value[out] =
+                            (out_queue_length << 8) |
+                            random_mt.random(0, 0xff);
                     }
+                    link_value = &m_link_value;
                 }
 
-                for (int i = 0; i < m_routing_table.size(); i++) {
-                    // pick the next link to look at
-                    int link = m_link_order[i].m_link;
-                    NetDest dst = m_routing_table[link];
-                    DPRINTF(RubyNetwork, "dst: %s\n", dst);
-
-                    if (!msg_dsts.intersectionIsNotEmpty(dst))
-                        continue;
-
-                    // Remember what link we're using
-                    output_links.push_back(link);
-
-                    // Need to remember which destinations need this message in
-                    // another vector.  This Set is the intersection of the
-                    // routing_table entry and the current destination set.  The
-                    // intersection must not be empty, since we are inside "if"
-                    output_link_destinations.push_back(msg_dsts.AND(dst));
-
-                    // Next, we update the msg_destination not to include
-                    // those nodes that were already handled by this link
-                    msg_dsts.removeNetDest(dst);
-                }
-
-                assert(msg_dsts.count() == 0);
+                // Split the destinations among the links that reach them
+                m_routing_table.route(net_msg_ptr->getInternalDestination(),
+                                      link_value, output_links,
+                                      output_link_destinations);
 
                 // Check for resources - for all outgoing queues
                 bool enough = true;
@@ -535,6 +532,10 @@ TopazSwitchFlow::wakeupVnet(int vnet)
                 // Dequeue msg
                 buffer->dequeue();
                 m_pending_message_count[vnet]--;
+                if (m_endpoint_in[incoming]) {
+                    m_network_ptr->increaseNumMsg(vnet,
+                        net_msg_ptr->getInternalDestination().count());
+                }
 
                 // Enqueue it - for all outgoing queues
                 for (int i=0; i<output_links.size(); i++) {
@@ -557,6 +558,10 @@ TopazSwitchFlow::wakeupVnet(int vnet)
                             incoming, vnet, outgoing, vnet);
 
                     m_out[outgoing][vnet]->enqueue(msg_ptr);
+                    if (m_endpoint_out[outgoing]) {
+                        m_network_ptr->decreaseNumMsg(vnet,
+                            output_link_destinations[i].count());
+                    }
                 }
             }
         }
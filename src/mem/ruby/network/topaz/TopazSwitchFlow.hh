@@ -42,19 +42,15 @@
 
 #include "mem/ruby/common/Consumer.hh"
 #include "mem/ruby/common/Global.hh"
+#include "mem/ruby/network/PortRoutingTable.hh"
+#include "mem/ruby/network/topaz/TopazMulticastMask.hh"
 
 class MessageBuffer;
 class NetDest;
 class TopazNetwork;
 class TopazSwitch;
-
-struct LinkOrder
-{
-    int m_link;
-    int m_value;
-};
-
-bool operator<(const LinkOrder& l1, const LinkOrder& l2);
+class TPZMessage;
+struct MessageTopaz;
 
 class TopazSwitchFlow : public Consumer
 {
@@ -66,21 +62,29 @@ class TopazSwitchFlow : public Consumer
     { return csprintf("TopazSwitch-%i", m_switch_id); }
 
     void init(TopazNetwork *);
-    void addInPort(const std::vector<MessageBuffer*>& in);
+    void addInPort(const std::vector<MessageBuffer*>& in,
+                   bool endpoint = false);
     void addOutPort(const std::vector<MessageBuffer*>& out,
-                    const NetDest& routing_table_entry);
+                    const NetDest& routing_table_entry,
+                    bool endpoint = false);
+    bool hasPendingEjections(int vnet) const;
+    bool hasPendingInjections() const;
 
     int getInLinks() const { return m_in.size(); }
     int getOutLinks() const { return m_out.size(); }
 
     void wakeup();
-    void wakeupVnet(int vnet);
+    void wakeupVnet(int vnet, bool endpoints = true);
     void storeEventInfo(int info);
-    int getUnicastDestination(NetDest destinations);
-    unsigned long long getMulticastDestination(NetDest& destinations);
-    void filterZeroDistanceMessages(MsgPtr& msg_ptr, int vnet, NetDest& destinations);
-    NetDest getConsumerDestinations(int switch_id, NetDest& mensaje);
-    void wakeUpTopaz();
+    int getUnicastDestination(const std::vector<NodeID>& nodes);
+    void getMulticastDestination(const std::vector<NodeID>& nodes,
+                                 TopazMulticastMask& routers);
+    void sendWideMulticast(int vnet, TPZMessage& msg,
+                           const TopazMulticastMask& routers);
+    void injectTopazMessage(MessageTopaz* copia);
+    void injectSampledMessage(MessageTopaz* copia);
+    void filterZeroDistanceMessages(MsgPtr& msg_ptr, int vnet,
+                                    std::vector<NodeID>& nodes);
     /*void addOutNetPort(const std::vector<MessageBuffer*>& out,
                        const NetDest& routing_table_entry);*/
     void printStats(std::ostream& out) const;
@@ -105,15 +109,23 @@ class TopazSwitchFlow : public Consumer
     //std::vector<std::map<int, MessageBuffer*> > m_in;
     //std::vector<std::map<int, MessageBuffer*> > m_out;
 
-    std::vector<NetDest> m_routing_table;
-    std::vector<LinkOrder> m_link_order;
+    // ports attached to a component rather than to another switch
+    std::vector<bool> m_endpoint_in;
+    std::vector<bool> m_endpoint_out;
+
+    // output links of each destination, and how clogged each link is
+    PortRoutingTable m_routing_table;
+    std::vector<int> m_link_value;
     uint32_t m_virtual_networks;
     int m_round_robin_start;
     int m_wakeups_wo_switch;
     TopazNetwork* m_network_ptr;
-    long unsigned m_ruby_start;
     long unsigned m_minimunTimeAgain;
     std::vector<int> m_pending_message_count;
+    // scratch router set, sized once to the number of TOPAZ routers
+    TopazMulticastMask m_multicast_routers;
+    // node numbers of the destinations of the message being injected
+    std::vector<NodeID> m_dest_nodes;
 };
 
 inline std::ostream&
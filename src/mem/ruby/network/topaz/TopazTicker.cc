@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2026 The University of Cantabria (Spain)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "base/time.hh"
+#include "debug/RubyNetwork.hh"
+#include "mem/ruby/network/MessageBuffer.hh"
+#include "mem/ruby/network/topaz/TopazTicker.hh"
+#include "mem/ruby/slicc_interface/NetworkMessage.hh"
+#include "mem/ruby/system/System.hh"
+
+using namespace std;
+
+TopazTicker::TopazTicker(TopazNetwork* network_ptr, Cycles period)
+    : m_network_ptr(network_ptr), m_period(period), m_event(this),
+      m_scheduled_time(0)
+{
+    assert(m_period > 0);
+}
+
+TopazTicker::~TopazTicker()
+{
+    if (m_event.scheduled())
+        m_network_ptr->deschedule(m_event);
+}
+
+void
+TopazTicker::scheduleAt(uTIME time)
+{
+    Cycles now = g_system_ptr->curCycle();
+    assert(time * m_period >= now);
+    m_scheduled_time = time;
+    m_network_ptr->reschedule(m_event,
+        g_system_ptr->clockEdge(Cycles(time * m_period - now)), true);
+}
+
+//******************************************************************************
+// Wakes the ticker up for the first network cycle not simulated yet. A tick
+// already pending for a later cycle, because TOPAZ had nothing to do until
+// then, is brought forward: the new packet may need that cycle.
+//******************************************************************************
+void
+TopazTicker::activate()
+{
+    Cycles now = g_system_ptr->curCycle();
+    uTIME time = (now + m_period - 1) / m_period;
+    uTIME topaz_time = m_network_ptr->getTopazTime();
+    if (time <= topaz_time)
+        time = topaz_time + 1;
+    if (m_event.scheduled() && m_scheduled_time <= time)
+        return;
+    scheduleAt(time);
+}
+
+//******************************************************************************
+// Runs TOPAZ up to the current network cycle and sends the messages it
+// delivered back to the Ruby queues. The cycles since the previous tick had
+// nothing to simulate, so they are skipped as a whole.
+//******************************************************************************
+void
+TopazTicker::tick()
+{
+    uTIME time = g_system_ptr->curCycle() / m_period;
+    assert(time > m_network_ptr->getTopazTime());
+    m_ticks_skipped += time - m_network_ptr->getTopazTime() - 1;
+    Time step_start;
+    step_start.setTimer();
+    m_deliveries.clear();
+    m_network_ptr->advanceTopaz(time, m_deliveries);
+    for (int i = 0; i < m_deliveries.size(); i++)
+        deliver(m_deliveries[i]);
+    Time step_end;
+    step_end.setTimer();
+    m_network_ptr->recordTopazStep(step_end - step_start);
+    m_ticks++;
+
+    if (m_network_ptr->getTopazMessages() != 0)
+        scheduleAt(m_network_ptr->getNextTopazTime(time));
+}
+
+void
+TopazTicker::deliver(const TopazDelivery& delivery)
+{
+    int consumer = delivery.m_router;
+    MessageTopaz* topaz_message = delivery.m_message;
+    assert (topaz_message->destinations>0);
+    MsgPtr localCopy = (topaz_message->message);
+    NetworkMessage* net_msg_ptr =
+                    dynamic_cast<NetworkMessage*>(localCopy.get());
+    int vvnet=topaz_message->vnet;
+    int isOrdered= m_network_ptr->isVNetOrdered(vvnet);
+    const NetDest& destinations = net_msg_ptr->getInternalDestination();
+    DPRINTF(RubyNetwork, "Arrival at switch: [%d] vnet: [%d] time: [%d].\n",
+                          consumer, vvnet, g_system_ptr->curCycle());
+    m_network_ptr->recordDelivery(topaz_message, consumer);
+    // only the machines attached to this router can be consumers
+    const vector<NodeID>& attached = m_network_ptr->getRouterNodes(consumer);
+    for (int j = 0; j < attached.size(); j++) {
+        NodeID node = attached[j];
+        if (!destinations.isElement(m_network_ptr->getMachineID(node)))
+            continue;
+        bool last = topaz_message->destinations == 1;
+        MsgPtr unaMas = m_network_ptr->messageForDestination(localCopy, last);
+        MessageBuffer* outputQueue=
+             m_network_ptr->getFromSimNetQueue(node, isOrdered, vvnet);
+        outputQueue->enqueue(unaMas);
+        topaz_message->destinations=topaz_message->destinations-1;
+        m_network_ptr->decreaseNumTopazMsg(vvnet, topaz_message->sampled);
+    }
+    int pendientes=topaz_message->destinations;
+    if (pendientes==0) m_network_ptr->releaseMessageTopaz(topaz_message);
+}
+
+void
+TopazTicker::regStats(const string& name,
+                      const Stats::Formula& host_seconds_per_step)
+{
+    m_ticks
+        .name(name + ".ticker_ticks")
+        .flags(Stats::nozero)
+        ;
+    m_ticks_skipped
+        .name(name + ".ticker_ticks_skipped")
+        .flags(Stats::nozero)
+        ;
+    m_host_seconds_saved
+        .name(name + ".ticker_host_seconds_saved")
+        .desc("host time the skipped ticks would have taken, at the "
+              "average cost of a tick")
+        .flags(Stats::nozero)
+        ;
+    m_host_seconds_saved = m_ticks_skipped * host_seconds_per_step;
+}
+
+void
+TopazTicker::print(ostream& out) const
+{
+    out << "[TopazTicker]";
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2026 The University of Cantabria (Spain)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Drives TOPAZ on the network clock, one tick every topaz_clock_ratio
+ * Ruby cycles. Each tick runs TOPAZ up to the current network cycle and
+ * hands the packets it delivered to the Ruby queues of their destinations.
+ * The ticker is only scheduled while TOPAZ holds packets, and then only
+ * for the network cycles in which TOPAZ has work to do when the engine
+ * can tell them (TPZ_NEXT_EVENT_TIME). Injections wake it up again.
+ */
+
+#ifndef __MEM_RUBY_NETWORK_TOPAZ_TOPAZTICKER_HH__
+#define __MEM_RUBY_NETWORK_TOPAZ_TOPAZTICKER_HH__
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "base/statistics.hh"
+#include "mem/ruby/common/TypeDefines.hh"
+#include "mem/ruby/network/topaz/TopazNetwork.hh"
+#include "sim/eventq.hh"
+
+class TopazTicker
+{
+  public:
+    TopazTicker(TopazNetwork* network_ptr, Cycles period);
+    ~TopazTicker();
+
+    std::string name() const { return m_network_ptr->name() + ".ticker"; }
+
+    // schedules a tick for the next network cycle, unless one is already
+    // pending for it
+    void activate();
+    bool isActive() const { return m_event.scheduled(); }
+
+    void regStats(const std::string& name,
+                  const Stats::Formula& host_seconds_per_step);
+    void print(std::ostream& out) const;
+
+  private:
+    // Private copy constructor and assignment operator
+    TopazTicker(const TopazTicker& obj);
+    TopazTicker& operator=(const TopazTicker& obj);
+
+    void tick();
+    void deliver(const TopazDelivery& delivery);
+    void scheduleAt(uTIME time);
+
+    TopazNetwork* m_network_ptr;
+    // Ruby cycles per network cycle
+    Cycles m_period;
+    EventWrapper<TopazTicker, &TopazTicker::tick> m_event;
+    // network cycle m_event is scheduled for
+    uTIME m_scheduled_time;
+    // packets TOPAZ delivered in the current network cycle
+    std::vector<TopazDelivery> m_deliveries;
+
+    Stats::Scalar m_ticks;
+    Stats::Scalar m_ticks_skipped;
+    Stats::Formula m_host_seconds_saved;
+};
+
+inline std::ostream&
+operator<<(std::ostream& out, const TopazTicker& obj)
+{
+    obj.print(out);
+    out << std::flush;
+    return out;
+}
+
+#endif // __MEM_RUBY_NETWORK_TOPAZ_TOPAZTICKER_HH__
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2026 The University of Cantabria (Spain)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "base/stl_helpers.hh"
+#include "mem/ruby/network/topaz/TopazWorkerPool.hh"
+
+using namespace std;
+using m5::stl_helpers::deletePointers;
+
+// Polls of the other side before blocking on a condition variable. It
+// covers a TOPAZ step on a small network, and costs a few microseconds of
+// host time when the wait is longer. A single core host does not spin.
+#define TOPAZ_SPIN_LIMIT 4096
+
+TopazWorkerPool::TopazWorkerPool(TopazStepper* stepper, int threads,
+                                 const vector<unsigned>& simulations)
+    : m_stepper(stepper), m_simulations(simulations),
+      m_participants(threads + 1),
+      m_spin_limit(thread::hardware_concurrency() > 1 ? TOPAZ_SPIN_LIMIT : 0),
+      m_generation(0), m_busy(0), m_exit(false), m_time(0)
+{
+    for (int i = 1; i < m_participants; i++)
+        m_threads.push_back(new thread(&TopazWorkerPool::main, this, i));
+}
+
+TopazWorkerPool::~TopazWorkerPool()
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_exit = true;
+        m_generation.fetch_add(1, memory_order_release);
+    }
+    m_start.notify_all();
+    for (int i = 0; i < m_threads.size(); i++)
+        m_threads[i]->join();
+    deletePointers(m_threads);
+}
+
+void
+TopazWorkerPool::runShare(int participant, uTIME time)
+{
+    for (unsigned i = participant; i < m_simulations.size();
+         i += m_participants) {
+        m_stepper->stepSimulation(m_simulations[i], time);
+    }
+}
+
+void
+TopazWorkerPool::run(uTIME time)
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_time = time;
+        m_busy.store(m_participants - 1, memory_order_relaxed);
+        m_generation.fetch_add(1, memory_order_release);
+    }
+    m_start.notify_all();
+    runShare(0, time);
+
+    for (int i = 0; i < m_spin_limit; i++) {
+        if (m_busy.load(memory_order_acquire) == 0)
+            return;
+    }
+    unique_lock<mutex> lock(m_mutex);
+    while (m_busy.load(memory_order_acquire) != 0)
+        m_done.wait(lock);
+}
+
+void
+TopazWorkerPool::main(int participant)
+{
+    unsigned generation = 0;
+    while (true) {
+        for (int i = 0; i < m_spin_limit; i++) {
+            if (m_generation.load(memory_order_acquire) != generation)
+                break;
+        }
+        uTIME time;
+        {
+            unique_lock<mutex> lock(m_mutex);
+            while (m_generation.load(memory_order_relaxed) == generation)
+                m_start.wait(lock);
+            generation = m_generation.load(memory_order_relaxed);
+            if (m_exit)
+                return;
+            time = m_time;
+        }
+        runShare(participant, time);
+        // the caller checks m_busy with m_mutex held before it waits
+        if (m_busy.fetch_sub(1, memory_order_acq_rel) == 1) {
+            lock_guard<mutex> lock(m_mutex);
+            m_done.notify_one();
+        }
+    }
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2026 The University of Cantabria (Spain)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ * Advances the per-vnet TOPAZ simulations of a non-unified network in
+ * parallel. Every network cycle the caller and the pool threads split the
+ * simulations among them and each one runs its share for the cycle. The
+ * caller gathers the deliveries simulation by simulation, so the results
+ * do not depend on which thread ran what.
+ *
+ * The pool knows the simulations only by index. A TopazStepper
+ * (TopazNetwork in the simulator) advances each of them.
+ *
+ * This is only safe when the engine keeps no state shared between its
+ * simulations. The in-tree reference engine declares that with
+ * TPZ_SIMULATIONS_INDEPENDENT. The external TOPAZ has a global simulator,
+ * pools and random generator, so TopazNetwork steps its simulations one
+ * after the other instead.
+ *
+ * Pool threads sleep on a condition variable between cycles, after a
+ * short spin, so they use no host time while TOPAZ is idle.
+ */
+
+#ifndef __MEM_RUBY_NETWORK_TOPAZ_TOPAZWORKERPOOL_HH__
+#define __MEM_RUBY_NETWORK_TOPAZ_TOPAZWORKERPOOL_HH__
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <TPZSimulator.hpp>
+
+class TopazStepper
+{
+  public:
+    virtual ~TopazStepper() {}
+
+    // runs network cycle time in one simulation, called from any thread
+    virtual void stepSimulation(unsigned simulation, uTIME time) = 0;
+};
+
+class TopazWorkerPool
+{
+  public:
+    TopazWorkerPool(TopazStepper* stepper, int threads,
+                    const std::vector<unsigned>& simulations);
+    ~TopazWorkerPool();
+
+    // runs network cycle time in each of the simulations and waits for all
+    void run(uTIME time);
+
+  private:
+    // Private copy constructor and assignment operator
+    TopazWorkerPool(const TopazWorkerPool& obj);
+    TopazWorkerPool& operator=(const TopazWorkerPool& obj);
+
+    void runShare(int participant, uTIME time);
+    void main(int participant);
+
+    TopazStepper* m_stepper;
+    // indices of the simulations to step
+    std::vector<unsigned> m_simulations;
+    // pool threads plus the caller
+    int m_participants;
+    const int m_spin_limit;
+    std::mutex m_mutex;
+    // signalled with a new generation, to release the pool threads
+    std::condition_variable m_start;
+    // signalled by the last pool thread to finish its share
+    std::condition_variable m_done;
+    // bumped once per cycle, only written with m_mutex held
+    std::atomic<unsigned> m_generation;
+    // pool threads still running their share
+    std::atomic<int> m_busy;
+    bool m_exit;
+    uTIME m_time;
+    std::vector<std::thread*> m_threads;
+};
+
+#endif // __MEM_RUBY_NETWORK_TOPAZ_TOPAZWORKERPOOL_HH__
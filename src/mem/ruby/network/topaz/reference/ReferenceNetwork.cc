@@ -0,0 +1,434 @@
+/*
+ * Copyright (c) 2026 The University of Cantabria (Spain)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <algorithm>
+#include <cassert>
+
+#include "base/misc.hh"
+#include "mem/ruby/network/topaz/reference/ReferenceNetwork.hh"
+
+using namespace std;
+
+ReferenceConfig::ReferenceConfig()
+    : m_torus(false), m_size_x(4), m_size_y(4), m_vnets(8),
+      m_vcs_per_vnet(2), m_buffer_flits(4), m_router_delay(1),
+      m_link_delay(1), m_flit_size(16), m_clock_ratio(1.0), m_unify(true)
+{
+}
+
+ReferenceNetwork::ReferenceNetwork(const ReferenceConfig& config)
+    : m_config(config),
+      m_vcs(config.m_vnets * config.m_vcs_per_vnet), m_waiting(0),
+      m_packets_injected(0), m_packets_delivered(0),
+      m_total_latency(0), m_total_flits(0)
+{
+    if (m_config.m_size_x < 1 || m_config.m_size_y < 1)
+        fatal("TOPAZ reference network %s: bad size %dx%d\n",
+              m_config.m_name, m_config.m_size_x, m_config.m_size_y);
+    if (m_config.m_vcs_per_vnet < 1 || m_config.m_buffer_flits < 1)
+        fatal("TOPAZ reference network %s: needs at least one channel and "
+              "one buffer per vnet\n", m_config.m_name);
+    if (m_config.m_torus && m_config.m_vcs_per_vnet % 2 != 0)
+        fatal("TOPAZ reference network %s: a torus needs an even number "
+              "of channels per vnet\n", m_config.m_name);
+    if (m_config.m_link_delay < 1 || m_config.m_router_delay < 0)
+        fatal("TOPAZ reference network %s: links take at least a cycle\n",
+              m_config.m_name);
+
+    m_routers.resize(m_config.m_size_x * m_config.m_size_y);
+    for (int i = 0; i < m_routers.size(); i++) {
+        Router& router = m_routers[i];
+        InputVC idle;
+        idle.m_out_port = -1;
+        idle.m_out_vc = -1;
+        router.m_in.assign(NUM_PORTS * m_vcs, idle);
+        router.m_credits.assign(NUM_PORTS * m_vcs, m_config.m_buffer_flits);
+        router.m_out_vc_busy.assign(NUM_PORTS * m_vcs, false);
+        router.m_round_robin.assign(NUM_PORTS, 0);
+        router.m_injected_flits = 0;
+        router.m_injection_vc = -1;
+        router.m_flits_sent = 0;
+        router.m_flits_received = 0;
+    }
+}
+
+int
+ReferenceNetwork::neighbor(int router, int port) const
+{
+    int size_x = m_config.m_size_x;
+    int size_y = m_config.m_size_y;
+    int x = router % size_x;
+    int y = router / size_x;
+    switch (port) {
+      case X_PLUS: x = (x + 1) % size_x; break;
+      case X_MINUS: x = (x + size_x - 1) % size_x; break;
+      case Y_PLUS: y = (y + 1) % size_y; break;
+      case Y_MINUS: y = (y + size_y - 1) % size_y; break;
+      default: break;
+    }
+    return y * size_x + x;
+}
+
+int
+ReferenceNetwork::oppositePort(int port)
+{
+    switch (port) {
+      case X_PLUS: return X_MINUS;
+      case X_MINUS: return X_PLUS;
+      case Y_PLUS: return Y_MINUS;
+      case Y_MINUS: return Y_PLUS;
+      default: return LOCAL;
+    }
+}
+
+// dimension of a port: 0 for the local port, 1 for X and 2 for Y
+static inline int
+portDimension(int port)
+{
+    return (port + 1) / 2;
+}
+
+//******************************************************************************
+// Dimension-order routing, X first. On a torus each ring is taken along
+// its shortest direction.
+//******************************************************************************
+int
+ReferenceNetwork::routePort(int router, int destination) const
+{
+    int size_x = m_config.m_size_x;
+    int size_y = m_config.m_size_y;
+    int dx = destination % size_x - router % size_x;
+    int dy = destination / size_x - router / size_x;
+    if (dx != 0) {
+        if (!m_config.m_torus)
+            return dx > 0 ? X_PLUS : X_MINUS;
+        int forward = (dx + size_x) % size_x;
+        return forward <= size_x - forward ? X_PLUS : X_MINUS;
+    }
+    if (dy != 0) {
+        if (!m_config.m_torus)
+            return dy > 0 ? Y_PLUS : Y_MINUS;
+        int forward = (dy + size_y) % size_y;
+        return forward <= size_y - forward ? Y_PLUS : Y_MINUS;
+    }
+    return LOCAL;
+}
+
+bool
+ReferenceNetwork::crossesDateline(int router, int port) const
+{
+    if (!m_config.m_torus)
+        return false;
+    int x = router % m_config.m_size_x;
+    int y = router / m_config.m_size_x;
+    switch (port) {
+      case X_PLUS: return x == m_config.m_size_x - 1;
+      case X_MINUS: return x == 0;
+      case Y_PLUS: return y == m_config.m_size_y - 1;
+      case Y_MINUS: return y == 0;
+      default: return false;
+    }
+}
+
+//******************************************************************************
+// Routes the packet at the front of an input channel and reserves a
+// channel of its class at the next router
+//******************************************************************************
+bool
+ReferenceNetwork::allocateOutputVC(int router, int in_port, int in_vc)
+{
+    Router& r = m_routers[router];
+    InputVC& input = r.m_in[vcIndex(in_port, in_vc)];
+    const Packet& packet = m_packets[input.m_flits.front().m_packet];
+    assert(input.m_flits.front().m_head);
+
+    int out_port = routePort(router, packet.m_destination);
+    if (out_port == LOCAL) {
+        input.m_out_port = LOCAL;
+        input.m_out_vc = 0;
+        return true;
+    }
+
+    int first = packet.m_vnet * m_config.m_vcs_per_vnet;
+    int count = m_config.m_vcs_per_vnet;
+    if (m_config.m_torus) {
+        count /= 2;
+        bool same_ring = portDimension(in_port) == portDimension(out_port);
+        bool crossed = same_ring && in_vc - first >= count;
+        if (crossed || crossesDateline(router, out_port))
+            first += count;
+    }
+    if (packet.m_ordered)
+        count = 1;
+
+    for (int vc = first; vc < first + count; vc++) {
+        int index = vcIndex(out_port, vc);
+        if (!r.m_out_vc_busy[index]) {
+            r.m_out_vc_busy[index] = true;
+            input.m_out_port = out_port;
+            input.m_out_vc = vc;
+            return true;
+        }
+    }
+    return false;
+}
+
+//******************************************************************************
+// Moves one flit per cycle from the source queue into a local channel
+//******************************************************************************
+void
+ReferenceNetwork::injectFlits(int router)
+{
+    Router& r = m_routers[router];
+    if (r.m_source.empty())
+        return;
+    int id = r.m_source.front();
+    const Packet& packet = m_packets[id];
+
+    if (r.m_injection_vc < 0) {
+        int first = packet.m_vnet * m_config.m_vcs_per_vnet;
+        int count = packet.m_ordered ? 1 : m_config.m_vcs_per_vnet;
+        for (int vc = first; vc < first + count; vc++) {
+            if (r.m_in[vcIndex(LOCAL, vc)].m_flits.size() <
+                m_config.m_buffer_flits) {
+                r.m_injection_vc = vc;
+                break;
+            }
+        }
+        if (r.m_injection_vc < 0)
+            return;
+    }
+
+    InputVC& input = r.m_in[vcIndex(LOCAL, r.m_injection_vc)];
+    if (input.m_flits.size() >= m_config.m_buffer_flits)
+        return;
+    Flit flit;
+    flit.m_packet = id;
+    flit.m_head = r.m_injected_flits == 0;
+    flit.m_tail = r.m_injected_flits == packet.m_flits - 1;
+    input.m_flits.push_back(flit);
+    m_waiting++;
+    if (++r.m_injected_flits == packet.m_flits) {
+        r.m_source.pop_front();
+        m_waiting--;
+        r.m_injected_flits = 0;
+        r.m_injection_vc = -1;
+    }
+}
+
+//******************************************************************************
+// Each output port takes one flit per cycle from the input channels routed
+// to it, round robin, and each input port sends at most one flit
+//******************************************************************************
+void
+ReferenceNetwork::traverseSwitch(int router, uTIME now)
+{
+    Router& r = m_routers[router];
+    int channels = NUM_PORTS * m_vcs;
+    bool input_used[NUM_PORTS] = { false };
+
+    for (int out_port = 0; out_port < NUM_PORTS; out_port++) {
+        for (int k = 0; k < channels; k++) {
+            int index = (r.m_round_robin[out_port] + k) % channels;
+            int in_port = index / m_vcs;
+            InputVC& input = r.m_in[index];
+            if (input_used[in_port] || input.m_flits.empty() ||
+                input.m_out_port != out_port)
+                continue;
+            int out_index = vcIndex(out_port, input.m_out_vc);
+            if (out_port != LOCAL && r.m_credits[out_index] == 0)
+                continue;
+
+            Flit flit = input.m_flits.front();
+            input.m_flits.pop_front();
+            m_waiting--;
+            input_used[in_port] = true;
+            r.m_round_robin[out_port] = (index + 1) % channels;
+
+            // the slot just freed goes back to the previous router
+            if (in_port != LOCAL) {
+                Transit credit;
+                credit.m_arrival = now + m_config.m_link_delay;
+                credit.m_router = neighbor(router, in_port);
+                credit.m_port = oppositePort(in_port);
+                credit.m_vc = index % m_vcs;
+                m_credits_in_flight.push_back(credit);
+            }
+
+            if (out_port == LOCAL) {
+                r.m_flits_received++;
+                if (flit.m_tail) {
+                    Packet& packet = m_packets[flit.m_packet];
+                    r.m_delivered.push_back(packet.m_external_info);
+                    m_packets_delivered++;
+                    m_total_latency += now - packet.m_generation_time;
+                    m_free_packets.push_back(flit.m_packet);
+                }
+            } else {
+                r.m_credits[out_index]--;
+                r.m_flits_sent++;
+                Transit transit;
+                transit.m_arrival =
+                    now + m_config.m_router_delay + m_config.m_link_delay;
+                transit.m_router = neighbor(router, out_port);
+                transit.m_port = oppositePort(out_port);
+                transit.m_vc = input.m_out_vc;
+                transit.m_flit = flit;
+                m_flits_in_flight.push_back(transit);
+                if (flit.m_tail)
+                    r.m_out_vc_busy[out_index] = false;
+            }
+
+            if (flit.m_tail)
+                input.m_out_port = -1;
+            break;
+        }
+    }
+}
+
+int
+ReferenceNetwork::allocatePacket()
+{
+    if (m_free_packets.empty()) {
+        m_packets.push_back(Packet());
+        return m_packets.size() - 1;
+    }
+    int id = m_free_packets.back();
+    m_free_packets.pop_back();
+    return id;
+}
+
+void
+ReferenceNetwork::inject(const TPZMessage& msg, int destination, uTIME now)
+{
+    const TPZPosition& source = msg.source();
+    int router = source.valueForCoordinate(TPZPosition::Y) *
+                 m_config.m_size_x +
+                 source.valueForCoordinate(TPZPosition::X);
+    assert(router < m_routers.size());
+    assert(destination < m_routers.size());
+    int vnet = msg.getVnet() - 1;
+    if (vnet < 0 || vnet >= m_config.m_vnets)
+        fatal("TOPAZ reference network %s: vnet %d out of range, raise "
+              "vnets\n", m_config.m_name, vnet);
+
+    int id = allocatePacket();
+    Packet& packet = m_packets[id];
+    packet.m_external_info = msg.getExternalInfo();
+    packet.m_destination = destination;
+    packet.m_vnet = vnet;
+    packet.m_ordered = msg.isOrdered();
+    packet.m_flits = msg.getPacketSize() > 0 ? msg.getPacketSize() : 1;
+    packet.m_generation_time = now;
+    m_routers[router].m_source.push_back(id);
+    m_waiting++;
+    m_packets_injected++;
+    m_total_flits += packet.m_flits;
+}
+
+void
+ReferenceNetwork::step(uTIME now)
+{
+    while (!m_flits_in_flight.empty() &&
+           m_flits_in_flight.front().m_arrival <= now) {
+        const Transit& transit = m_flits_in_flight.front();
+        m_routers[transit.m_router].m_in[vcIndex(transit.m_port,
+                                                 transit.m_vc)]
+            .m_flits.push_back(transit.m_flit);
+        m_flits_in_flight.pop_front();
+        m_waiting++;
+    }
+    while (!m_credits_in_flight.empty() &&
+           m_credits_in_flight.front().m_arrival <= now) {
+        const Transit& credit = m_credits_in_flight.front();
+        m_routers[credit.m_router].m_credits[vcIndex(credit.m_port,
+                                                     credit.m_vc)]++;
+        m_credits_in_flight.pop_front();
+    }
+
+    int channels = NUM_PORTS * m_vcs;
+    for (int i = 0; i < m_routers.size(); i++) {
+        injectFlits(i);
+        // rotate the starting channel so none of them starves
+        for (int k = 0; k < channels; k++) {
+            int index = (now + k) % channels;
+            InputVC& input = m_routers[i].m_in[index];
+            if (!input.m_flits.empty() && input.m_out_port < 0)
+                allocateOutputVC(i, index / m_vcs, index % m_vcs);
+        }
+        traverseSwitch(i, now);
+    }
+}
+
+uTIME
+ReferenceNetwork::nextEventTime(uTIME now) const
+{
+    if (m_waiting > 0)
+        return now;
+    if (m_flits_in_flight.empty())
+        return TPZ_NO_EVENT;
+    return max(now, m_flits_in_flight.front().m_arrival);
+}
+
+void*
+ReferenceNetwork::popDelivered(int router)
+{
+    assert(router < m_routers.size());
+    deque<void*>& delivered = m_routers[router].m_delivered;
+    if (delivered.empty())
+        return NULL;
+    void* info = delivered.front();
+    delivered.pop_front();
+    return info;
+}
+
+void
+ReferenceNetwork::printStats(ostream& out) const
+{
+    out << "Reference network " << m_config.m_name << ": "
+        << (m_config.m_torus ? "torus " : "mesh ")
+        << m_config.m_size_x << "x" << m_config.m_size_y << endl;
+    out << "Packets injected      = " << m_packets_injected << endl;
+    out << "Packets delivered     = " << m_packets_delivered << endl;
+    out << "Flits injected        = " << m_total_flits << endl;
+    out << "Average latency       = "
+        << (m_packets_delivered ?
+            double(m_total_latency) / m_packets_delivered : 0.0)
+        << " cycles" << endl;
+}
+
+void
+ReferenceNetwork::printRouterStats(ostream& out) const
+{
+    for (int i = 0; i < m_routers.size(); i++) {
+        out << "Router " << i << ": flits sent = "
+            << m_routers[i].m_flits_sent << ", flits received = "
+            << m_routers[i].m_flits_received << endl;
+    }
+}
@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2026 The University of Cantabria (Spain)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ * Flit-level network engine behind the in-tree TOPAZ API. Routers sit on
+ * a 2D mesh or torus and use dimension-order routing, wormhole switching
+ * and credit-based flow control. Each vnet owns its own set of virtual
+ * channels, so protocol messages of different classes never block each
+ * other. On a torus, the channels of a vnet are split in two halves and
+ * packets move to the upper half when they cross the wrap-around link of
+ * a dimension (dateline), which keeps the rings deadlock free.
+ *
+ * Every hop costs router_delay + link_delay cycles and each output port
+ * moves one flit per cycle. Ordered packets always take the first channel
+ * of their class, so a flow never overtakes itself.
+ *
+ * A cycle in which no router holds a flit or a packet to inject only lands
+ * the flits and credits arriving in it. Nothing reads the credits until a
+ * flit is buffered again, so such cycles can be skipped up to the next
+ * flit arrival (nextEventTime) without changing any result.
+ */
+
+#ifndef __MEM_RUBY_NETWORK_TOPAZ_REFERENCE_REFERENCENETWORK_HH__
+#define __MEM_RUBY_NETWORK_TOPAZ_REFERENCE_REFERENCENETWORK_HH__
+
+#include <deque>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "mem/ruby/network/topaz/reference/TPZSimulator.hpp"
+
+struct ReferenceConfig
+{
+    ReferenceConfig();
+
+    std::string m_name;
+    bool m_torus;
+    int m_size_x;
+    int m_size_y;
+    int m_vnets;
+    int m_vcs_per_vnet;
+    int m_buffer_flits;
+    int m_router_delay;
+    int m_link_delay;
+    unsigned m_flit_size;
+    double m_clock_ratio;
+    bool m_unify;
+};
+
+class ReferenceNetwork
+{
+  public:
+    ReferenceNetwork(const ReferenceConfig& config);
+
+    int getNumRouters() const { return m_routers.size(); }
+    int getSizeX() const { return m_config.m_size_x; }
+
+    void inject(const TPZMessage& msg, int destination, uTIME now);
+    void step(uTIME now);
+    // first cycle from now on in which step has work to do, TPZ_NO_EVENT
+    // when the network is empty
+    uTIME nextEventTime(uTIME now) const;
+    void* popDelivered(int router);
+
+    void printStats(std::ostream& out) const;
+    void printRouterStats(std::ostream& out) const;
+
+  private:
+    enum Port { LOCAL, X_PLUS, X_MINUS, Y_PLUS, Y_MINUS, NUM_PORTS };
+
+    struct Packet
+    {
+        void* m_external_info;
+        int m_destination;
+        int m_vnet;
+        bool m_ordered;
+        int m_flits;
+        uTIME m_generation_time;
+    };
+
+    struct Flit
+    {
+        int m_packet;
+        bool m_head;
+        bool m_tail;
+    };
+
+    struct InputVC
+    {
+        std::deque<Flit> m_flits;
+        // route of the packet at the front, m_out_port < 0 when none
+        int m_out_port;
+        int m_out_vc;
+    };
+
+    // a flit on a link, or a credit on its way back
+    struct Transit
+    {
+        uTIME m_arrival;
+        int m_router;
+        int m_port;
+        int m_vc;
+        Flit m_flit;
+    };
+
+    struct Router
+    {
+        std::vector<InputVC> m_in;
+        std::vector<int> m_credits;
+        std::vector<bool> m_out_vc_busy;
+        std::vector<int> m_round_robin;
+        std::deque<int> m_source;
+        int m_injected_flits;
+        int m_injection_vc;
+        std::deque<void*> m_delivered;
+        unsigned long long m_flits_sent;
+        unsigned long long m_flits_received;
+    };
+
+    int vcIndex(int port, int vc) const { return port * m_vcs + vc; }
+    int neighbor(int router, int port) const;
+    static int oppositePort(int port);
+    int routePort(int router, int destination) const;
+    bool crossesDateline(int router, int port) const;
+    bool allocateOutputVC(int router, int in_port, int in_vc);
+    void injectFlits(int router);
+    void traverseSwitch(int router, uTIME now);
+    int allocatePacket();
+
+    ReferenceConfig m_config;
+    int m_vcs;
+    std::vector<Router> m_routers;
+    std::vector<Packet> m_packets;
+    std::vector<int> m_free_packets;
+    std::deque<Transit> m_flits_in_flight;
+    std::deque<Transit> m_credits_in_flight;
+    // packets in source queues plus flits in input channels
+    int m_waiting;
+
+    unsigned long long m_packets_injected;
+    unsigned long long m_packets_delivered;
+    unsigned long long m_total_latency;
+    unsigned long long m_total_flits;
+};
+
+#endif // __MEM_RUBY_NETWORK_TOPAZ_REFERENCE_REFERENCENETWORK_HH__
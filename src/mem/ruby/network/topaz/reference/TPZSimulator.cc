@@ -0,0 +1,318 @@
+/*
+ * Copyright (c) 2026 The University of Cantabria (Spain)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <cassert>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include "base/misc.hh"
+#include "mem/ruby/network/topaz/reference/ReferenceNetwork.hh"
+#include "mem/ruby/network/topaz/reference/TPZSimulator.hpp"
+
+using namespace std;
+
+TPZMessage::TPZMessage()
+    : m_external_info(NULL), m_generation_time(0), m_vnet(1),
+      m_message_size(1), m_packet_size(1), m_ordered(false),
+      m_multicast(false), m_msgmask(0)
+{
+}
+
+void
+TPZMessage::setMsgmaskWord(int word, unsigned long long mask)
+{
+    assert(word >= 0);
+    if (word == 0) {
+        m_msgmask = mask;
+        return;
+    }
+    if (word > (int)m_upper_msgmask.size())
+        m_upper_msgmask.resize(word, 0);
+    m_upper_msgmask[word - 1] = mask;
+}
+
+unsigned long long
+TPZMessage::getMsgmaskWord(int word) const
+{
+    assert(word >= 0);
+    if (word == 0)
+        return m_msgmask;
+    return word <= (int)m_upper_msgmask.size() ? m_upper_msgmask[word - 1] : 0;
+}
+
+TPZNetwork::TPZNetwork(const ReferenceConfig& config, const uTIME& clock)
+    : m_engine(new ReferenceNetwork(config)), m_clock(clock)
+{
+}
+
+TPZNetwork::~TPZNetwork()
+{
+    delete m_engine;
+}
+
+TPZPosition
+TPZNetwork::CreatePosition(int router) const
+{
+    assert(router < m_engine->getNumRouters());
+    return TPZPosition(router % m_engine->getSizeX(),
+                       router / m_engine->getSizeX());
+}
+
+int
+TPZNetwork::Number_of_nodes() const
+{
+    return m_engine->getNumRouters();
+}
+
+//******************************************************************************
+// A multicast becomes one packet per router of its mask, all of them
+// carrying the same external info
+//******************************************************************************
+void
+TPZNetwork::sendMessage(const TPZMessage& msg)
+{
+    uTIME now = m_clock;
+    if (!msg.isMulticast()) {
+        const TPZPosition& destiny = msg.destiny();
+        m_engine->inject(msg, destiny.valueForCoordinate(TPZPosition::Y) *
+                              m_engine->getSizeX() +
+                              destiny.valueForCoordinate(TPZPosition::X),
+                         now);
+        return;
+    }
+    for (int word = 0; word < msg.getMsgmaskWords(); word++) {
+        unsigned long long mask = msg.getMsgmaskWord(word);
+        for (int router = word * 64; mask != 0; router++, mask >>= 1) {
+            if (mask & 1)
+                m_engine->inject(msg, router, now);
+        }
+    }
+}
+
+void
+TPZNetwork::writeComponentStatus(ostream& out)
+{
+    m_engine->printRouterStats(out);
+}
+
+TPZSimulation::TPZSimulation(const ReferenceConfig& config)
+    : m_config(new ReferenceConfig(config)), m_current_time(0),
+      m_network(new TPZNetwork(config, m_current_time)),
+      m_packet_length(1)
+{
+}
+
+TPZSimulation::~TPZSimulation()
+{
+    delete m_network;
+    delete m_config;
+}
+
+bool
+TPZSimulation::needToUnify() const
+{
+    return m_config->m_unify;
+}
+
+unsigned
+TPZSimulation::getFlitSize() const
+{
+    return m_config->m_flit_size;
+}
+
+double
+TPZSimulation::getNetworkClockRatioSGML() const
+{
+    return m_config->m_clock_ratio;
+}
+
+void
+TPZSimulation::run(uTIME cycles)
+{
+    uTIME end = m_current_time + cycles;
+    while (m_current_time < end) {
+        uTIME next = nextEventTime();
+        if (next >= end) {
+            m_current_time = end;
+            break;
+        }
+        m_network->engine()->step(next);
+        m_current_time = next + 1;
+    }
+}
+
+uTIME
+TPZSimulation::nextEventTime() const
+{
+    return m_network->engine()->nextEventTime(m_current_time);
+}
+
+void*
+TPZSimulation::getExternalInfoAt(const TPZPosition& position)
+{
+    int router = position.valueForCoordinate(TPZPosition::Y) *
+                 m_network->engine()->getSizeX() +
+                 position.valueForCoordinate(TPZPosition::X);
+    return m_network->engine()->popDelivered(router);
+}
+
+void
+TPZSimulation::writeSimulationStatus(ostream& out)
+{
+    out << "Simulation time       = " << m_current_time << " cycles" << endl;
+    m_network->engine()->printStats(out);
+}
+
+//******************************************************************************
+// The configuration is read from the TOPAZ init file given with -F. The
+// simulation named with -s is looked up among its entries like
+//   <ReferenceSimulation id="name" topology="torus" sizeX="4" sizeY="4"
+//                        vnets="8" vcs="2" buffers="4" routerDelay="1"
+//                        linkDelay="1" flitSize="16" clockRatio="1"
+//                        unify="true">
+// and the first entry is used when none matches. Missing attributes keep
+// the defaults of ReferenceConfig.
+//******************************************************************************
+static string
+argumentAfter(const string& arguments, const string& option)
+{
+    istringstream words(arguments);
+    string word;
+    while (words >> word) {
+        if (word == option && words >> word)
+            return word;
+    }
+    return "";
+}
+
+static bool
+attribute(const string& tag, const string& name, string& value)
+{
+    string key = " " + name + "=\"";
+    size_t start = tag.find(key);
+    if (start == string::npos)
+        return false;
+    start += key.size();
+    size_t end = tag.find('"', start);
+    if (end == string::npos)
+        return false;
+    value = tag.substr(start, end - start);
+    return true;
+}
+
+static ReferenceConfig
+parseConfig(const string& arguments)
+{
+    string name = argumentAfter(arguments, "-s");
+    string file_name = argumentAfter(arguments, "-F");
+    ifstream file(file_name.c_str());
+    if (!file.good())
+        fatal("TOPAZ reference network: can't open %s\n", file_name);
+
+    stringstream contents;
+    contents << file.rdbuf();
+    const string text = contents.str();
+    const string opening = "<ReferenceSimulation";
+    string tag;
+    for (size_t start = text.find(opening); start != string::npos;
+         start = text.find(opening, start + 1)) {
+        size_t end = text.find('>', start);
+        if (end == string::npos)
+            break;
+        string candidate = text.substr(start, end - start);
+        for (int i = 0; i < candidate.size(); i++) {
+            if (isspace(candidate[i]))
+                candidate[i] = ' ';
+        }
+        string id;
+        if (tag.empty() || (attribute(candidate, "id", id) && id == name)) {
+            tag = candidate;
+            if (id == name)
+                break;
+        }
+    }
+    if (tag.empty())
+        fatal("TOPAZ reference network: no <ReferenceSimulation> in %s\n",
+              file_name);
+
+    ReferenceConfig config;
+    string value;
+    config.m_name = attribute(tag, "id", value) ? value : name;
+    if (attribute(tag, "topology", value))
+        config.m_torus = value == "torus";
+    if (attribute(tag, "sizeX", value))
+        config.m_size_x = atoi(value.c_str());
+    if (attribute(tag, "sizeY", value))
+        config.m_size_y = atoi(value.c_str());
+    if (attribute(tag, "vnets", value))
+        config.m_vnets = atoi(value.c_str());
+    if (attribute(tag, "vcs", value))
+        config.m_vcs_per_vnet = atoi(value.c_str());
+    if (attribute(tag, "buffers", value))
+        config.m_buffer_flits = atoi(value.c_str());
+    if (attribute(tag, "routerDelay", value))
+        config.m_router_delay = atoi(value.c_str());
+    if (attribute(tag, "linkDelay", value))
+        config.m_link_delay = atoi(value.c_str());
+    if (attribute(tag, "flitSize", value))
+        config.m_flit_size = atoi(value.c_str());
+    if (attribute(tag, "clockRatio", value))
+        config.m_clock_ratio = atof(value.c_str());
+    if (attribute(tag, "unify", value))
+        config.m_unify = value != "false";
+    return config;
+}
+
+TPZSimulator::~TPZSimulator()
+{
+    for (int i = 0; i < m_simulations.size(); i++)
+        delete m_simulations[i];
+}
+
+void
+TPZSimulator::createSimulation(const TPZString& arguments)
+{
+    m_simulations.push_back(new TPZSimulation(parseConfig(arguments)));
+}
+
+TPZSimulation*
+TPZSimulator::getSimulation(unsigned index)
+{
+    assert(index >= 1 && index <= m_simulations.size());
+    return m_simulations[index - 1];
+}
+
+TPZSimulator*
+TPZSIMULATOR()
+{
+    static TPZSimulator simulator;
+    return &simulator;
+}
@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2026 The University of Cantabria (Spain)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ * The subset of the TOPAZ simulator API used by the TOPAZ network bridge,
+ * implemented on top of ReferenceNetwork. It lets the bridge be built and
+ * run without the external TOPAZ distribution.
+ */
+
+#ifndef __MEM_RUBY_NETWORK_TOPAZ_REFERENCE_TPZSIMULATOR_HPP__
+#define __MEM_RUBY_NETWORK_TOPAZ_REFERENCE_TPZSIMULATOR_HPP__
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+typedef unsigned long long uTIME;
+
+// Every TPZSimulation owns all of its state, so different simulations can
+// be run from different host threads at the same time
+#define TPZ_SIMULATIONS_INDEPENDENT 1
+
+// Multicast masks are not limited to the first 64 routers, see
+// TPZMessage::setMsgmaskWord
+#define TPZ_WIDE_MSGMASK 1
+
+// TPZSimulation::nextEventTime tells how far the simulation can be run
+// before it has anything to do
+#define TPZ_NEXT_EVENT_TIME 1
+#define TPZ_NO_EVENT (~0ULL)
+
+class ReferenceNetwork;
+struct ReferenceConfig;
+
+class TPZString : public std::string
+{
+  public:
+    TPZString() {}
+    TPZString(const char* str) : std::string(str) {}
+    TPZString(const std::string& str) : std::string(str) {}
+};
+
+class TPZPosition
+{
+  public:
+    enum TPZCoordinate { X, Y, Z };
+
+    TPZPosition() : m_x(0), m_y(0) {}
+    TPZPosition(int x, int y) : m_x(x), m_y(y) {}
+
+    int
+    valueForCoordinate(TPZCoordinate coordinate) const
+    {
+        return coordinate == X ? m_x : coordinate == Y ? m_y : 0;
+    }
+
+  private:
+    int m_x;
+    int m_y;
+};
+
+class TPZMessage
+{
+  public:
+    TPZMessage();
+
+    void setExternalInfo(void* info) { m_external_info = info; }
+    void* getExternalInfo() const { return m_external_info; }
+    void setGenerationTime(uTIME time) { m_generation_time = time; }
+    uTIME generationTime() const { return m_generation_time; }
+    void setSource(const TPZPosition& source) { m_source = source; }
+    const TPZPosition& source() const { return m_source; }
+    void setDestiny(const TPZPosition& destiny) { m_destiny = destiny; }
+    const TPZPosition& destiny() const { return m_destiny; }
+    void setVnet(int vnet) { m_vnet = vnet; }
+    int getVnet() const { return m_vnet; }
+    void setMessageSize(int size) { m_message_size = size; }
+    void setPacketSize(int size) { m_packet_size = size; }
+    int getPacketSize() const { return m_packet_size; }
+    void setOrdered() { m_ordered = true; }
+    bool isOrdered() const { return m_ordered; }
+    void setMulticast() { m_multicast = true; }
+    void clearMulticast() { m_multicast = false; }
+    bool isMulticast() const { return m_multicast; }
+    void setMsgmask(unsigned long long mask) { m_msgmask = mask; }
+    unsigned long long getMsgmask() const { return m_msgmask; }
+    // routers 64 * word to 64 * word + 63 of a multicast, word 0 being
+    // the mask of setMsgmask
+    void setMsgmaskWord(int word, unsigned long long mask);
+    unsigned long long getMsgmaskWord(int word) const;
+    int getMsgmaskWords() const { return m_upper_msgmask.size() + 1; }
+
+  private:
+    void* m_external_info;
+    uTIME m_generation_time;
+    TPZPosition m_source;
+    TPZPosition m_destiny;
+    int m_vnet;
+    int m_message_size;
+    int m_packet_size;
+    bool m_ordered;
+    bool m_multicast;
+    unsigned long long m_msgmask;
+    std::vector<unsigned long long> m_upper_msgmask;
+};
+
+class TPZNetwork
+{
+  public:
+    TPZNetwork(const ReferenceConfig& config, const uTIME& clock);
+    ~TPZNetwork();
+
+    TPZPosition CreatePosition(int router) const;
+    int Number_of_nodes() const;
+    void sendMessage(const TPZMessage& msg);
+    void writeComponentStatus(std::ostream& out);
+
+    ReferenceNetwork* engine() { return m_engine; }
+
+  private:
+    // Private copy constructor and assignment operator
+    TPZNetwork(const TPZNetwork& obj);
+    TPZNetwork& operator=(const TPZNetwork& obj);
+
+    ReferenceNetwork* m_engine;
+    // current time of the simulation that owns this network
+    const uTIME& m_clock;
+};
+
+class TPZSimulation
+{
+  public:
+    TPZSimulation(const ReferenceConfig& config);
+    ~TPZSimulation();
+
+    bool needToUnify() const;
+    unsigned getFlitSize() const;
+    double getNetworkClockRatioSGML() const;
+    void setPacketLength(int flits) { m_packet_length = flits; }
+
+    TPZNetwork* getNetwork() { return m_network; }
+    uTIME getCurrentTime() const { return m_current_time; }
+    void setCurrentTime(uTIME time) { m_current_time = time; }
+    // cycles in which nothing happens are skipped, not simulated
+    void run(uTIME cycles);
+    // first cycle from getCurrentTime() on in which run has work to do,
+    // TPZ_NO_EVENT when the simulation is empty
+    uTIME nextEventTime() const;
+    void* getExternalInfoAt(const TPZPosition& position);
+
+    void writeSimulationStatus(std::ostream& out);
+
+  private:
+    // Private copy constructor and assignment operator
+    TPZSimulation(const TPZSimulation& obj);
+    TPZSimulation& operator=(const TPZSimulation& obj);
+
+    ReferenceConfig* m_config;
+    uTIME m_current_time;
+    TPZNetwork* m_network;
+    int m_packet_length;
+};
+
+class TPZSimulator
+{
+  public:
+    ~TPZSimulator();
+
+    void createSimulation(const TPZString& arguments);
+    // simulations are numbered from 1, as in TOPAZ
+    TPZSimulation* getSimulation(unsigned index);
+
+  private:
+    std::vector<TPZSimulation*> m_simulations;
+};
+
+TPZSimulator* TPZSIMULATOR();
+
+#endif // __MEM_RUBY_NETWORK_TOPAZ_REFERENCE_TPZSIMULATOR_HPP__
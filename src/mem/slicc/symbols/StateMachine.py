@@ -588,6 +588,10 @@ m_net_ptr->set${network}NetQueue(m_version + base, $ordered, $vnet,
                     # A buffer
                     code('$vid->setRandomization(${{var["random"]}});')
 
+                # Set the in-order fast path
+                if "fast_path" in var:
+                    code('$vid->setFastPath(${{var["fast_path"]}});')
+
                 # Set Priority
                 if "rank" in var:
                     code('$vid->setPriority(${{var["rank"]}})')
@@ -658,6 +662,10 @@ $c_ident::init()
                         # A buffer
                         code('$vid->setRandomization(${{var["random"]}});')
 
+                    # Set the in-order fast path
+                    if "fast_path" in var:
+                        code('$vid->setFastPath(${{var["fast_path"]}});')
+
                     # Set Priority
                     if vtype.isBuffer and "rank" in var:
                         code('$vid->setPriority(${{var["rank"]}});')
@@ -730,6 +738,21 @@ void
 $c_ident::regStats()
 {
     AbstractController::regStats();
+''')
+
+        # Stall statistics of the buffers read through an in_port, named
+        # after the buffer. Messages only stall there.
+        code.indent()
+        stall_buffers = []
+        for port in self.in_ports:
+            match = re.search(r"m_(\w+)_ptr", port.code)
+            buffer_name = match.group(1) if match else port.ident
+            if buffer_name not in stall_buffers:
+                stall_buffers.append(buffer_name)
+                code('${{port.code}}.regStallStats(name() + ".$buffer_name");')
+        code.dedent()
+
+        code('''
 
     if (m_version == 0) {
         for (${ident}_Event event = ${ident}_Event_FIRST;
@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2026 The University of Cantabria (Spain)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ * Checks the FlitAllocator bookkeeping: constructor arguments reach the
+ * flit, destroy() runs the destructor, destroyed slots are reused before
+ * a new slab is added, and the counters the networks report add up.
+ * Then times creating and destroying flit_d objects against new and
+ * delete, with a window of flits in flight as in a busy network.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "base/cprintf.hh"
+#include "mem/ruby/network/garnet/FlitAllocator.hh"
+#include "mem/ruby/network/garnet/fixed-pipeline/flit_d.hh"
+#include "unittest/unittest.hh"
+
+using namespace std;
+using UnitTest::setCase;
+
+// counts its live instances
+struct Tracked
+{
+    static int live;
+    int m_id;
+    Tracked(int id) : m_id(id) { live++; }
+    ~Tracked() { live--; }
+};
+
+int Tracked::live = 0;
+
+// a message that tells when the last reference to it goes
+class TestMessage : public Message
+{
+  public:
+    static bool deleted;
+    TestMessage() : Message(0) { deleted = false; }
+    ~TestMessage() { deleted = true; }
+    Message *clone() const { return new TestMessage(*this); }
+    void print(ostream& out) const { out << "[TestMessage]"; }
+    bool functionalRead(Packet *pkt) { return false; }
+    bool functionalWrite(Packet *pkt) { return false; }
+};
+
+bool TestMessage::deleted = false;
+
+static const int IN_FLIGHT = 512;
+static const int ROUNDS = 4000000;
+
+// Replaces the oldest of IN_FLIGHT flits with a new one, ROUNDS times
+template <class Create, class Destroy>
+double
+timeChurn(Create create, Destroy destroy, long& checksum)
+{
+    vector<flit_d *> window(IN_FLIGHT);
+    for (int i = 0; i < IN_FLIGHT; i++)
+        window[i] = create(i);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int r = 0; r < ROUNDS; r++) {
+        int oldest = r % IN_FLIGHT;
+        checksum += window[oldest]->get_id();
+        destroy(window[oldest]);
+        window[oldest] = create(r);
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+    for (int i = 0; i < IN_FLIGHT; i++)
+        destroy(window[i]);
+    return elapsed.count() * 1e9 / ROUNDS;
+}
+
+int
+main()
+{
+    setCase("Construction and destruction");
+    {
+        FlitAllocator<Tracked> allocator(4);
+        Tracked *a = allocator.create(7);
+        Tracked *b = allocator.create(8);
+        EXPECT_EQ(a->m_id, 7);
+        EXPECT_EQ(b->m_id, 8);
+        EXPECT_EQ(Tracked::live, 2);
+        allocator.destroy(a);
+        allocator.destroy(b);
+        EXPECT_EQ(Tracked::live, 0);
+
+        MsgPtr msg = new TestMessage;
+        FlitAllocator<flit_d> flits;
+        flit_d *flit = flits.create(1, 2, 3, 4, msg, Cycles(5));
+        EXPECT_EQ(flit->get_id(), 1);
+        EXPECT_EQ(flit->get_vc(), 2);
+        EXPECT_EQ(flit->get_vnet(), 3);
+        EXPECT_EQ(flit->get_size(), 4);
+        EXPECT_EQ(flit->get_time(), Cycles(5));
+        EXPECT_EQ(flit->get_type(), BODY_);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(flit) % alignof(flit_d), 0);
+        // the flit holds the last reference, and drops it when destroyed
+        msg = NULL;
+        EXPECT_FALSE(TestMessage::deleted);
+        flits.destroy(flit);
+        EXPECT_TRUE(TestMessage::deleted);
+    }
+
+    setCase("Slots are reused before slabs are added");
+    {
+        FlitAllocator<Tracked> allocator(4);
+        vector<Tracked *> held;
+        for (int i = 0; i < 4; i++)
+            held.push_back(allocator.create(i));
+        EXPECT_EQ(allocator.get_slab_count(), 1);
+
+        // the last slot freed is the first handed out again
+        Tracked *freed = held[2];
+        allocator.destroy(freed);
+        Tracked *reused = allocator.create(10);
+        EXPECT_TRUE(reused == freed);
+        EXPECT_EQ(allocator.get_slab_count(), 1);
+        held[2] = reused;
+
+        // a fifth flit needs a second slab
+        held.push_back(allocator.create(4));
+        EXPECT_EQ(allocator.get_slab_count(), 2);
+
+        // steady churn below the peak adds nothing
+        for (int r = 0; r < 1000; r++) {
+            allocator.destroy(held[r % held.size()]);
+            held[r % held.size()] = allocator.create(r);
+        }
+        EXPECT_EQ(allocator.get_slab_count(), 2);
+        EXPECT_EQ(allocator.get_allocation_count(), 1006);
+        EXPECT_EQ(allocator.get_peak_in_use(), 5);
+        EXPECT_EQ(Tracked::live, 5);
+
+        bool distinct = true;
+        for (int i = 0; i < held.size(); i++) {
+            for (int j = i + 1; j < held.size(); j++)
+                distinct = distinct && held[i] != held[j];
+        }
+        EXPECT_TRUE(distinct);
+
+        for (int i = 0; i < held.size(); i++)
+            allocator.destroy(held[i]);
+        EXPECT_EQ(Tracked::live, 0);
+    }
+
+    setCase("Flits in flight when the allocator goes away");
+    {
+        FlitAllocator<Tracked> *allocator = new FlitAllocator<Tracked>(2);
+        for (int i = 0; i < 5; i++)
+            allocator->create(i);
+        EXPECT_EQ(allocator->get_slab_count(), 3);
+        // their storage goes with the slabs, they are not destructed
+        delete allocator;
+        EXPECT_EQ(Tracked::live, 5);
+        Tracked::live = 0;
+    }
+
+    long checksum = 0;
+    MsgPtr msg = new TestMessage;
+    double heap = timeChurn(
+        [&](int id) { return new flit_d(id, 0, 0, 5, msg, Cycles(id)); },
+        [](flit_d *flit) { delete flit; }, checksum);
+    FlitAllocator<flit_d> allocator;
+    double slab = timeChurn(
+        [&](int id) {
+            return allocator.create(id, 0, 0, 5, msg, Cycles(id));
+        },
+        [&](flit_d *flit) { allocator.destroy(flit); }, checksum);
+    cprintf("create/destroy of a flit_d with %d in flight: new/delete "
+            "%.1f ns, FlitAllocator %.1f ns (%.1fx), checksum %d\n",
+            IN_FLIGHT, heap, slab, heap / slab, checksum);
+
+    return UnitTest::printResults();
+}
@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2026 The University of Cantabria (Spain)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ * Checks that flitBuffer_d hands out its flits in the order of
+ * flit_d::greater, the order of the heap it replaced: flits inserted in
+ * order, late flits that have to move back past others, a ring whose
+ * head has wrapped around, and growth while it is wrapped. Flits with
+ * equal keys must leave first in, first out.
+ */
+
+#include <algorithm>
+#include <vector>
+
+#include "mem/ruby/network/garnet/fixed-pipeline/flitBuffer_d.hh"
+#include "unittest/unittest.hh"
+
+using namespace std;
+using UnitTest::setCase;
+
+// a small LCG, so the sequences are the same on every host
+static unsigned long long lcg_state = 1;
+
+static unsigned
+nextRandom()
+{
+    lcg_state = lcg_state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return lcg_state >> 33;
+}
+
+static bool
+leavesBefore(flit_d *a, flit_d *b)
+{
+    return flit_d::greater(b, a);
+}
+
+/*
+ * Inserts flits at random times up to a window ahead of the current
+ * cycle and pops the ready ones, keeping at most max_held of them. Every
+ * pop must be the flit a heap ordered by flit_d::greater would give.
+ */
+static bool
+matchesHeap(flitBuffer_d &buffer, int window, int max_held, int flits)
+{
+    vector<flit_d *> all;
+    vector<flit_d *> heap;
+    bool same = true;
+    Cycles now(0);
+    int next_id = 0;
+
+    while (next_id < flits || !heap.empty()) {
+        if (next_id < flits && heap.size() < max_held &&
+            nextRandom() % 3 != 0) {
+            Cycles time(now + nextRandom() % window);
+            flit_d *flit = new flit_d(next_id, 0, 0, flits, MsgPtr(), time);
+            next_id++;
+            all.push_back(flit);
+            buffer.insert(flit);
+            heap.push_back(flit);
+            push_heap(heap.begin(), heap.end(), flit_d::greater);
+        } else if (!heap.empty() && buffer.isReady(now)) {
+            flit_d *expected = heap.front();
+            pop_heap(heap.begin(), heap.end(), flit_d::greater);
+            heap.pop_back();
+            same = same && buffer.getTopFlit() == expected;
+        } else {
+            ++now;
+        }
+    }
+    same = same && buffer.isEmpty();
+
+    for (int i = 0; i < all.size(); i++)
+        delete all[i];
+    return same;
+}
+
+int
+main()
+{
+    setCase("Flits inserted in order");
+    {
+        flitBuffer_d buffer;
+        vector<flit_d *> flits;
+        for (int i = 0; i < 10; i++) {
+            Cycles time(1 + i / 2);
+            flits.push_back(new flit_d(i, 0, 0, 10, MsgPtr(), time));
+            buffer.insert(flits.back());
+        }
+        EXPECT_FALSE(buffer.isReady(Cycles(0)));
+        EXPECT_TRUE(buffer.isReady(Cycles(1)));
+        bool in_order = true;
+        for (int i = 0; i < 10; i++)
+            in_order = in_order && buffer.getTopFlit() == flits[i];
+        EXPECT_TRUE(in_order);
+        EXPECT_TRUE(buffer.isEmpty());
+        for (int i = 0; i < 10; i++)
+            delete flits[i];
+    }
+
+    setCase("Late flits");
+    {
+        flitBuffer_d buffer;
+        flit_d early(0, 0, 0, 4, MsgPtr(), Cycles(5));
+        flit_d later(1, 0, 0, 4, MsgPtr(), Cycles(7));
+        flit_d late_time(2, 0, 0, 4, MsgPtr(), Cycles(3));
+        flit_d late_id(3, 0, 0, 4, MsgPtr(), Cycles(7));
+        flit_d low_id(0, 0, 0, 4, MsgPtr(), Cycles(7));
+        buffer.insert(&early);
+        buffer.insert(&later);
+        buffer.insert(&late_id);
+        // leaves before everything in the buffer
+        buffer.insert(&late_time);
+        // same time as two flits in the buffer, but a lower id
+        buffer.insert(&low_id);
+        EXPECT_TRUE(buffer.getTopFlit() == &late_time);
+        EXPECT_TRUE(buffer.getTopFlit() == &early);
+        EXPECT_TRUE(buffer.getTopFlit() == &low_id);
+        EXPECT_TRUE(buffer.getTopFlit() == &later);
+        EXPECT_TRUE(buffer.getTopFlit() == &late_id);
+        EXPECT_TRUE(buffer.isEmpty());
+
+        EXPECT_TRUE(matchesHeap(buffer, 8, 64, 100000));
+    }
+
+    setCase("Equal keys leave first in, first out");
+    {
+        flitBuffer_d buffer;
+        vector<flit_d *> credits;
+        for (int i = 0; i < 6; i++) {
+            credits.push_back(new flit_d(i % 2, true, Cycles(4)));
+            buffer.insert(credits.back());
+        }
+        flit_d first(0, true, Cycles(2));
+        buffer.insert(&first);
+        EXPECT_TRUE(buffer.getTopFlit() == &first);
+        bool fifo = true;
+        for (int i = 0; i < 6; i++)
+            fifo = fifo && buffer.getTopFlit() == credits[i];
+        EXPECT_TRUE(fifo);
+        for (int i = 0; i < 6; i++)
+            delete credits[i];
+    }
+
+    setCase("Wraparound");
+    {
+        // the ring stays at four slots, so the head wraps every four pops
+        flitBuffer_d buffer;
+        buffer.reserve(4);
+        vector<flit_d *> flits;
+        for (int i = 0; i < 3; i++) {
+            flits.push_back(new flit_d(i, 0, 0, 64, MsgPtr(), Cycles(i)));
+            buffer.insert(flits.back());
+        }
+        bool in_order = true;
+        for (int i = 3; i < 64; i++) {
+            // every other flit is late and has to pass the newest one
+            Cycles time(i % 2 ? i - 1 : i + 1);
+            flits.push_back(new flit_d(i, 0, 0, 64, MsgPtr(), time));
+            buffer.insert(flits.back());
+            flit_d *top = buffer.getTopFlit();
+            in_order = in_order && !leavesBefore(buffer.peekTopFlit(), top);
+        }
+        flit_d *last = buffer.getTopFlit();
+        while (!buffer.isEmpty()) {
+            flit_d *top = buffer.getTopFlit();
+            in_order = in_order && leavesBefore(last, top);
+            last = top;
+        }
+        EXPECT_TRUE(in_order);
+        for (int i = 0; i < flits.size(); i++)
+            delete flits[i];
+
+        EXPECT_TRUE(matchesHeap(buffer, 3, 4, 100000));
+    }
+
+    setCase("Growth");
+    {
+        // grows while the head is in the middle of the ring
+        flitBuffer_d buffer;
+        buffer.reserve(4);
+        vector<flit_d *> flits;
+        for (int i = 0; i < 3; i++) {
+            flits.push_back(new flit_d(i, 0, 0, 100, MsgPtr(), Cycles(0)));
+            buffer.insert(flits.back());
+        }
+        buffer.getTopFlit();
+        buffer.getTopFlit();
+        // ids from 99 down, so every insert goes to the front
+        for (int i = 99; i >= 3; i--) {
+            flits.push_back(new flit_d(i, 0, 0, 100, MsgPtr(), Cycles(1)));
+            buffer.insert(flits.back());
+        }
+        flit_d *first = new flit_d(1, 0, 0, 100, MsgPtr(), Cycles(1));
+        flits.push_back(first);
+        buffer.insert(first);
+        EXPECT_TRUE(buffer.getTopFlit() == flits[2]);
+        EXPECT_TRUE(buffer.getTopFlit() == first);
+        bool in_order = true;
+        for (int i = 3; i < 100; i++)
+            in_order = in_order && buffer.getTopFlit()->get_id() == i;
+        EXPECT_TRUE(in_order);
+        EXPECT_TRUE(buffer.isEmpty());
+        for (int i = 0; i < flits.size(); i++)
+            delete flits[i];
+
+        flitBuffer_d unbounded;
+        EXPECT_TRUE(matchesHeap(unbounded, 50, 1000, 100000));
+    }
+
+    return UnitTest::printResults();
+}
@@ -0,0 +1,361 @@
+/*
+ * Copyright (c) 2026 The University of Cantabria (Spain)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Drives the in-tree TOPAZ reference engine directly. Checks the zero-load
+ * latency of a packet, that every packet of a saturating random load is
+ * delivered once at its destination on a mesh and on a torus, that ordered
+ * packets of a flow keep their order, that a multicast reaches routers
+ * beyond the first 64, that skipping idle cycles does not move any
+ * delivery, and that a fixed random load still gives the delivery cycles
+ * recorded below, so a change to the engine that moves them is seen.
+ */
+
+#include <vector>
+
+#include "base/cprintf.hh"
+#include "mem/ruby/network/topaz/reference/ReferenceNetwork.hh"
+#include "mem/ruby/network/topaz/reference/TPZSimulator.hpp"
+#include "unittest/unittest.hh"
+
+using namespace std;
+using UnitTest::setCase;
+
+// Recorded with the engine as committed. A change in timing or in
+// arbitration moves them, and then they have to be checked and updated.
+static const uTIME ZERO_LOAD_CORNER_TO_CORNER = 12;
+static const unsigned long long MESH_4X4_DELIVERY_SUM = 30515394;
+static const unsigned long long TORUS_4X4_DELIVERY_SUM = 30291068;
+static const unsigned long long TORUS_8X8_DELIVERY_SUM = 11037246;
+
+// what a packet carries as TOPAZ external info
+struct TestPacket
+{
+    int m_destination;
+    int m_flow_sequence;
+    int m_deliveries;
+    uTIME m_delivered_at;
+    unsigned m_delivery_index;
+};
+
+// packets delivered so far, over all the routers
+static unsigned delivery_count;
+
+// a small LCG, so the loads are the same on every host
+static unsigned long long lcg_state;
+
+static unsigned
+nextRandom()
+{
+    lcg_state = lcg_state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return lcg_state >> 33;
+}
+
+static ReferenceConfig
+makeConfig(bool torus, int size)
+{
+    ReferenceConfig config;
+    config.m_name = torus ? "torus" : "mesh";
+    config.m_torus = torus;
+    config.m_size_x = size;
+    config.m_size_y = size;
+    return config;
+}
+
+static void
+send(ReferenceNetwork& network, int size_x, int source, TestPacket& packet,
+     int vnet, int flits, bool ordered, uTIME now)
+{
+    TPZMessage msg;
+    msg.setExternalInfo(&packet);
+    msg.setSource(TPZPosition(source % size_x, source / size_x));
+    msg.setVnet(vnet + 1);
+    msg.setPacketSize(flits);
+    if (ordered)
+        msg.setOrdered();
+    network.inject(msg, packet.m_destination, now);
+}
+
+// records what each router delivered in cycle now
+static int
+collect(ReferenceNetwork& network, uTIME now)
+{
+    int delivered = 0;
+    for (int router = 0; router < network.getNumRouters(); router++) {
+        void* info;
+        while ((info = network.popDelivered(router)) != NULL) {
+            TestPacket* packet = static_cast<TestPacket*>(info);
+            EXPECT_EQ(packet->m_destination, router);
+            packet->m_deliveries++;
+            packet->m_delivered_at = now;
+            packet->m_delivery_index = delivery_count++;
+            delivered++;
+        }
+    }
+    return delivered;
+}
+
+// steps the network once and records what each router delivered
+static int
+stepAndCollect(ReferenceNetwork& network, uTIME now)
+{
+    network.step(now);
+    return collect(network, now);
+}
+
+//******************************************************************************
+// Random unicast load: each router injects a packet of one to five flits
+// with the given probability (in 1/256) every cycle, for 'cycles' cycles,
+// then the network is drained. Returns the sum of the delivery cycles.
+//******************************************************************************
+static unsigned long long
+randomLoad(bool torus, int size, int rate, int cycles, bool& all_delivered)
+{
+    ReferenceNetwork network(makeConfig(torus, size));
+    int routers = size * size;
+    vector<TestPacket> packets;
+    packets.reserve(routers * cycles);
+    lcg_state = 1;
+
+    uTIME now = 0;
+    int in_flight = 0;
+    for (; now < cycles; now++) {
+        for (int source = 0; source < routers; source++) {
+            if (nextRandom() % 256 >= rate)
+                continue;
+            TestPacket packet = { int(nextRandom() % routers), 0, 0, 0, 0 };
+            packets.push_back(packet);
+            send(network, size, source, packets.back(), nextRandom() % 8,
+                 1 + nextRandom() % 5, false, now);
+            in_flight++;
+        }
+        in_flight -= stepAndCollect(network, now);
+    }
+    // a deadlocked network would never drain
+    for (uTIME limit = now + 100000; in_flight > 0 && now < limit; now++)
+        in_flight -= stepAndCollect(network, now);
+
+    all_delivered = in_flight == 0;
+    unsigned long long sum = 0;
+    for (int i = 0; i < packets.size(); i++) {
+        all_delivered = all_delivered && packets[i].m_deliveries == 1;
+        sum += packets[i].m_delivered_at;
+    }
+    return sum;
+}
+
+int
+main()
+{
+    setCase("Zero-load latency");
+    {
+        // six hops from corner to corner, router delay plus link delay
+        // each. Injection and ejection happen in the cycle of the hop.
+        ReferenceNetwork network(makeConfig(false, 4));
+        TestPacket packet = { 15, 0, 0, 0, 0 };
+        send(network, 4, 0, packet, 0, 1, false, 0);
+        for (uTIME now = 0; now < 100 && !packet.m_deliveries; now++)
+            stepAndCollect(network, now);
+        EXPECT_EQ(packet.m_deliveries, 1);
+        EXPECT_EQ(packet.m_delivered_at, ZERO_LOAD_CORNER_TO_CORNER);
+    }
+
+    setCase("Saturating random load");
+    {
+        bool all_delivered;
+        unsigned long long sum;
+        sum = randomLoad(false, 4, 128, 2000, all_delivered);
+        EXPECT_TRUE(all_delivered);
+        EXPECT_EQ(sum, MESH_4X4_DELIVERY_SUM);
+        sum = randomLoad(true, 4, 128, 2000, all_delivered);
+        EXPECT_TRUE(all_delivered);
+        EXPECT_EQ(sum, TORUS_4X4_DELIVERY_SUM);
+        sum = randomLoad(true, 8, 64, 1000, all_delivered);
+        EXPECT_TRUE(all_delivered);
+        EXPECT_EQ(sum, TORUS_8X8_DELIVERY_SUM);
+    }
+
+    setCase("Ordered flows keep their order");
+    {
+        // every router sends an ordered flow to the opposite corner of
+        // the torus, mixed with unordered packets on the same vnet
+        ReferenceNetwork network(makeConfig(true, 4));
+        const int flow_length = 50;
+        vector<TestPacket> packets;
+        packets.reserve(16 * flow_length * 2);
+        lcg_state = 7;
+        uTIME now = 0;
+        for (int n = 0; n < flow_length; n++, now++) {
+            for (int source = 0; source < 16; source++) {
+                TestPacket ordered = { 15 - source, n, 0, 0, 0 };
+                packets.push_back(ordered);
+                send(network, 4, source, packets.back(), 2,
+                     1 + nextRandom() % 5, true, now);
+                TestPacket unordered = { int(nextRandom() % 16), -1, 0, 0, 0 };
+                packets.push_back(unordered);
+                send(network, 4, source, packets.back(), 2,
+                     1 + nextRandom() % 5, false, now);
+            }
+            stepAndCollect(network, now);
+        }
+        for (int i = 0; i < 100000; i++, now++)
+            stepAndCollect(network, now);
+
+        bool in_order = true;
+        bool all_delivered = true;
+        for (int i = 0; i < packets.size(); i++) {
+            all_delivered = all_delivered && packets[i].m_deliveries == 1;
+            // the previous packet of the same flow sits 32 entries back
+            if (packets[i].m_flow_sequence > 0 &&
+                packets[i].m_delivery_index <
+                packets[i - 32].m_delivery_index)
+                in_order = false;
+        }
+        EXPECT_TRUE(all_delivered);
+        EXPECT_TRUE(in_order);
+    }
+
+    setCase("Multicast beyond 64 routers");
+    {
+        // 144 routers, so the mask spans three words. The destinations
+        // are the corners plus both ends of each word boundary.
+        ReferenceConfig config = makeConfig(false, 12);
+        uTIME clock = 0;
+        TPZNetwork network(config, clock);
+        const int destinations[] = { 0, 11, 63, 64, 127, 128, 132, 143 };
+        const int num_destinations = 8;
+        vector<unsigned long long> mask(3, 0);
+        for (int i = 0; i < num_destinations; i++)
+            mask[destinations[i] / 64] |= 1ULL << (destinations[i] % 64);
+
+        TestPacket packet = { -1, 0, 0, 0, 0 };
+        TPZMessage msg;
+        msg.setExternalInfo(&packet);
+        msg.setSource(TPZPosition(5, 5));
+        msg.setVnet(1);
+        msg.setPacketSize(3);
+        msg.setMulticast();
+        for (int word = 0; word < mask.size(); word++)
+            msg.setMsgmaskWord(word, mask[word]);
+        EXPECT_EQ(msg.getMsgmaskWords(), 3);
+        network.sendMessage(msg);
+
+        vector<int> received(network.Number_of_nodes(), 0);
+        for (; clock < 1000; clock++) {
+            network.engine()->step(clock);
+            for (int router = 0; router < received.size(); router++) {
+                while (network.engine()->popDelivered(router) != NULL)
+                    received[router]++;
+            }
+        }
+        bool exact = true;
+        for (int router = 0; router < received.size(); router++) {
+            bool wanted = mask[router / 64] & (1ULL << (router % 64));
+            exact = exact && received[router] == (wanted ? 1 : 0);
+        }
+        EXPECT_TRUE(exact);
+    }
+
+    setCase("Skipping idle cycles");
+    {
+        // a sparse load, run once cycle by cycle and once jumping from
+        // event to event, must deliver every packet in the same cycle
+        struct Injection { uTIME m_time; int m_source; int m_flits; };
+        const int size = 4;
+        vector<Injection> injections;
+        vector<TestPacket> stepped;
+        lcg_state = 11;
+        for (uTIME now = 0; now < 20000; now++) {
+            if (nextRandom() % 128 != 0)
+                continue;
+            // sometimes a burst of a few packets in the same cycle
+            int burst = nextRandom() % 4 == 0 ? 1 + nextRandom() % 6 : 1;
+            for (int i = 0; i < burst; i++) {
+                Injection injection = { now, int(nextRandom() % 16),
+                                        1 + int(nextRandom() % 5) };
+                injections.push_back(injection);
+                TestPacket packet = { int(nextRandom() % 16), 0, 0, 0, 0 };
+                stepped.push_back(packet);
+            }
+        }
+        vector<TestPacket> skipped = stepped;
+
+        ReferenceNetwork network(makeConfig(true, size));
+        uTIME now = 0;
+        for (int next = 0; now < 21000; now++) {
+            for (; next < injections.size() &&
+                   injections[next].m_time == now; next++) {
+                send(network, size, injections[next].m_source,
+                     stepped[next], 0, injections[next].m_flits, false, now);
+            }
+            stepAndCollect(network, now);
+        }
+
+        TPZSimulation simulation(makeConfig(true, size));
+        uTIME steps = 0;
+        int next = 0;
+        while (true) {
+            uTIME event = simulation.nextEventTime();
+            if (next < injections.size())
+                event = min(event, injections[next].m_time);
+            if (event == TPZ_NO_EVENT)
+                break;
+            // no step runs before the event
+            simulation.run(event - simulation.getCurrentTime());
+            for (; next < injections.size() &&
+                   injections[next].m_time == event; next++) {
+                TPZMessage msg;
+                msg.setExternalInfo(&skipped[next]);
+                msg.setSource(TPZPosition(injections[next].m_source % size,
+                                          injections[next].m_source / size));
+                msg.setDestiny(TPZPosition(skipped[next].m_destination % size,
+                                           skipped[next].m_destination / size));
+                msg.setVnet(1);
+                msg.setPacketSize(injections[next].m_flits);
+                simulation.getNetwork()->sendMessage(msg);
+            }
+            simulation.run(1);
+            collect(*simulation.getNetwork()->engine(), event);
+            steps++;
+        }
+
+        bool same = true;
+        for (int i = 0; i < stepped.size(); i++) {
+            same = same && stepped[i].m_deliveries == 1 &&
+                   skipped[i].m_deliveries == 1 &&
+                   stepped[i].m_delivered_at == skipped[i].m_delivered_at;
+        }
+        EXPECT_TRUE(same);
+        // most of the 20000 cycles are idle
+        EXPECT_TRUE(steps < now / 4);
+        cprintf("%d packets, %d of %d cycles stepped\n", stepped.size(),
+                steps, now);
+    }
+
+    return UnitTest::printResults();
+}
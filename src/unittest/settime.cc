@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2026 The University of Cantabria (Spain)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Times the Ruby Set operations the networks use on every message
+ * (copy, AND, OR, count and intersection tests) at 16, 64, 256 and 1024
+ * nodes, against a copy of the previous Set, which allocated its words
+ * on the heap past 64 nodes. Sizes above NUMBER_BITS_PER_SET take the
+ * heap fallback of the new Set too, build with NUMBER_BITS_PER_SET=1024
+ * to time them in place.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "base/cprintf.hh"
+#include "mem/ruby/common/Set.hh"
+
+using namespace std;
+
+// The Set before it was fixed in size, reduced to the timed operations
+class DynamicSet
+{
+  private:
+    static const int LONG_BITS = 64;
+    int m_nSize;
+    int m_nArrayLen;
+    long *m_p_nArray;
+    long m_p_nArray_Static[1];
+
+  public:
+    DynamicSet(int size) : m_p_nArray(NULL) { setSize(size); }
+    DynamicSet(const DynamicSet& obj) : m_p_nArray(NULL)
+    {
+        setSize(obj.m_nSize);
+        for (int i = 0; i < m_nArrayLen; i++)
+            m_p_nArray[i] = obj.m_p_nArray[i];
+    }
+    ~DynamicSet()
+    {
+        if (m_p_nArray != m_p_nArray_Static)
+            delete [] m_p_nArray;
+    }
+
+    void
+    setSize(int size)
+    {
+        m_nSize = size;
+        m_nArrayLen = (size + LONG_BITS - 1) / LONG_BITS;
+        if (m_p_nArray && m_p_nArray != m_p_nArray_Static)
+            delete [] m_p_nArray;
+        if (m_nArrayLen <= 1)
+            m_p_nArray = m_p_nArray_Static;
+        else
+            m_p_nArray = new long[m_nArrayLen];
+        for (int i = 0; i < m_nArrayLen; i++)
+            m_p_nArray[i] = 0;
+    }
+
+    void add(int index) { m_p_nArray[index >> 6] |= 1UL << (index & 63); }
+
+    DynamicSet
+    AND(const DynamicSet& andSet) const
+    {
+        DynamicSet result(m_nSize);
+        for (int i = 0; i < m_nArrayLen; i++)
+            result.m_p_nArray[i] = m_p_nArray[i] & andSet.m_p_nArray[i];
+        return result;
+    }
+
+    DynamicSet
+    OR(const DynamicSet& orSet) const
+    {
+        DynamicSet result(m_nSize);
+        for (int i = 0; i < m_nArrayLen; i++)
+            result.m_p_nArray[i] = m_p_nArray[i] | orSet.m_p_nArray[i];
+        return result;
+    }
+
+    int
+    count() const
+    {
+        int counter = 0;
+        for (int i = 0; i < m_nArrayLen; i++) {
+            long mask = 1;
+            for (int j = 0; j < LONG_BITS; j++) {
+                if ((m_p_nArray[i] & mask) != 0)
+                    counter++;
+                mask = mask << 1;
+            }
+        }
+        return counter;
+    }
+
+    bool
+    intersectionIsEmpty(const DynamicSet& other_set) const
+    {
+        for (int i = 0; i < m_nArrayLen; i++)
+            if (m_p_nArray[i] & other_set.m_p_nArray[i])
+                return false;
+        return true;
+    }
+};
+
+static const int SETS = 256;
+static const int ROUNDS = 2000;
+
+// Sets of sparse random members, as destination sets usually are
+template <class S>
+vector<S>
+makeSets(int size)
+{
+    vector<S> sets(SETS, S(size));
+    for (int s = 0; s < SETS; s++) {
+        for (int m = 0; m < 4; m++)
+            sets[s].add(random() % size);
+    }
+    return sets;
+}
+
+template <class S>
+double
+timeOperations(int size, long& checksum)
+{
+    vector<S> sets = makeSets<S>(size);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int s = 0; s < SETS; s++) {
+            const S& a = sets[s];
+            const S& b = sets[(s + r + 1) % SETS];
+            if (!a.intersectionIsEmpty(b))
+                checksum += a.AND(b).count();
+            checksum += a.OR(b).count();
+        }
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    return elapsed.count() * 1e9 / (ROUNDS * SETS);
+}
+
+int
+main()
+{
+    const int sizes[] = { 16, 64, 256, 1024 };
+    long checksum = 0;
+
+    cprintf("%8s %16s %16s %8s\n", "nodes", "dynamic (ns/op)",
+            "fixed (ns/op)", "speedup");
+    for (int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        int size = sizes[i];
+        double dynamic = timeOperations<DynamicSet>(size, checksum);
+        double fixed = timeOperations<Set>(size, checksum);
+        cprintf("%8d %16.1f %16.1f %7.1fx\n", size, dynamic, fixed,
+                dynamic / fixed);
+    }
+
+    // keeps the work from being optimized away
+    cprintf("checksum %d\n", checksum);
+    return 0;
+}
@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2026 The University of Cantabria (Spain)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Runs the per-vnet networks of the Mesh8x8PerVnet entry of
+ * TPZReference.ini (unify="false") under the same random load twice, once
+ * stepping the simulations one after the other and once with a
+ * TopazWorkerPool of several threads, the way TopazNetwork does. Every
+ * packet has to be delivered once, in the same cycle in both runs. The
+ * host time of both runs is printed.
+ *
+ * The init file is looked up in the working directory, run the test from
+ * the top of the tree or pass its path as the only argument.
+ */
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "base/cprintf.hh"
+#include "base/time.hh"
+#include "mem/ruby/network/topaz/TopazWorkerPool.hh"
+#include "unittest/unittest.hh"
+
+using namespace std;
+using UnitTest::setCase;
+
+static const int VNETS = 8;
+static const int WORKERS = 4;
+static const int LOAD_CYCLES = 1000;
+// packets per router and cycle, in 1/256
+static const int LOAD_RATE = 24;
+
+// what a packet carries as TOPAZ external info
+struct TestPacket
+{
+    int m_destination;
+    int m_deliveries;
+    uTIME m_delivered_at;
+};
+
+// steps a simulation and stamps what it delivered, as
+// TopazNetwork::stepSimulation does
+class TestStepper : public TopazStepper
+{
+  public:
+    TestStepper() : m_delivered(2 * VNETS + 1, 0) {}
+
+    void
+    stepSimulation(unsigned index, uTIME time)
+    {
+        TPZSimulation* simulation = TPZSIMULATOR()->getSimulation(index);
+        simulation->setCurrentTime(time - 1);
+        simulation->run(1);
+        TPZNetwork* network = simulation->getNetwork();
+        for (int router = 0; router < network->Number_of_nodes();
+             router++) {
+            void* info;
+            while ((info = simulation->getExternalInfoAt(
+                        network->CreatePosition(router))) != NULL) {
+                TestPacket* packet = static_cast<TestPacket*>(info);
+                packet->m_deliveries++;
+                packet->m_delivered_at = time;
+                m_delivered[index]++;
+            }
+        }
+    }
+
+    // packets delivered by each simulation, each one only written by the
+    // thread stepping it
+    vector<int> m_delivered;
+};
+
+// a small LCG, so both runs get the same load
+static unsigned long long lcg_state;
+
+static unsigned
+nextRandom()
+{
+    lcg_state = lcg_state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return lcg_state >> 33;
+}
+
+//******************************************************************************
+// Random unicast load on the simulations first to first + VNETS - 1, one
+// per vnet, stepped by the pool when there is one. Returns the host
+// seconds it took.
+//******************************************************************************
+static double
+runLoad(unsigned first, TestStepper& stepper, TopazWorkerPool* pool,
+        deque<TestPacket>& packets)
+{
+    int routers = TPZSIMULATOR()->getSimulation(first)->getNetwork()->
+                                                  Number_of_nodes();
+    packets.clear();
+    lcg_state = 5;
+
+    Time start;
+    start.setTimer();
+    uTIME time = 1;
+    for (; time < 100000; time++) {
+        for (int vnet = 0; time <= LOAD_CYCLES && vnet < VNETS; vnet++) {
+            TPZNetwork* network =
+                TPZSIMULATOR()->getSimulation(first + vnet)->getNetwork();
+            for (int source = 0; source < routers; source++) {
+                if (nextRandom() % 256 >= LOAD_RATE)
+                    continue;
+                TestPacket packet = { int(nextRandom() % routers), 0, 0 };
+                packets.push_back(packet);
+                TPZMessage msg;
+                msg.setExternalInfo(&packets.back());
+                msg.setSource(network->CreatePosition(source));
+                msg.setDestiny(network->CreatePosition(
+                                   packets.back().m_destination));
+                // the vnet of the message, as TopazSwitchFlow sets it
+                msg.setVnet(vnet + 1);
+                msg.setPacketSize(1 + nextRandom() % 5);
+                network->sendMessage(msg);
+            }
+        }
+
+        if (pool) {
+            pool->run(time);
+        } else {
+            for (int vnet = 0; vnet < VNETS; vnet++)
+                stepper.stepSimulation(first + vnet, time);
+        }
+
+        if (time > LOAD_CYCLES) {
+            int delivered = 0;
+            for (int vnet = 0; vnet < VNETS; vnet++)
+                delivered += stepper.m_delivered[first + vnet];
+            if (delivered == packets.size())
+                break;
+        }
+    }
+    Time end;
+    end.setTimer();
+    return end - start;
+}
+
+int
+main(int argc, char** argv)
+{
+    string init_file = argc > 1 ? argv[1] : "TPZReference.ini";
+    string arguments = "TPZSimul -q -s Mesh8x8PerVnet -t EMPTY -d 100000 "
+                       "-v 4 -F " + init_file;
+    // one set of simulations per run, numbered from 1
+    for (int i = 0; i < 2 * VNETS; i++)
+        TPZSIMULATOR()->createSimulation(arguments);
+
+    setCase("Per-vnet networks");
+    EXPECT_FALSE(TPZSIMULATOR()->getSimulation(1)->needToUnify());
+
+    setCase("Worker pool matches serial stepping");
+    {
+        TestStepper stepper;
+        deque<TestPacket> serial;
+        double serial_seconds = runLoad(1, stepper, NULL, serial);
+
+        vector<unsigned> simulations;
+        for (int vnet = 0; vnet < VNETS; vnet++)
+            simulations.push_back(VNETS + 1 + vnet);
+        TopazWorkerPool pool(&stepper, WORKERS - 1, simulations);
+        deque<TestPacket> pooled;
+        double pooled_seconds = runLoad(VNETS + 1, stepper, &pool, pooled);
+
+        EXPECT_EQ(serial.size(), pooled.size());
+        bool same = serial.size() == pooled.size();
+        for (int i = 0; same && i < serial.size(); i++) {
+            same = serial[i].m_deliveries == 1 &&
+                   pooled[i].m_deliveries == 1 &&
+                   serial[i].m_delivered_at == pooled[i].m_delivered_at;
+        }
+        EXPECT_TRUE(same);
+
+        cprintf("%d packets on %d networks: serial %.3fs, %d threads "
+                "%.3fs, speedup %.2f\n", serial.size(), VNETS,
+                serial_seconds, WORKERS, pooled_seconds,
+                serial_seconds / pooled_seconds);
+    }
+
+    return UnitTest::printResults();
+}
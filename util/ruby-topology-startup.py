@@ -0,0 +1,120 @@
+#! /usr/bin/env python
+
+# Copyright (c) 2026 The University of Cantabria (Spain)
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+
+# Startup-time benchmark for the Ruby network topologies.
+#
+# Runs configs/example/ruby_network_test.py for one simulated cycle with
+# each topology in configs/topologies and several numbers of CPUs, and
+# reports the host seconds each run took. With a single cycle simulated,
+# the time is dominated by building the network, most of it computing the
+# routing tables in Topology::createLinks.
+#
+# Example:
+#
+# util/ruby-topology-startup.py -s 16,64,256 build/X86_MESI_Two_Level/gem5.opt
+#
+# Options after '--' are passed to the configuration script, for instance
+# '-- --garnet-network=fixed' to time the Garnet network instead.
+#
+
+import os, sys, time, math
+import subprocess
+import optparse
+
+# the instantiable topologies of configs/topologies
+topologies = ['Crossbar', 'Pt2Pt', 'Mesh', 'MeshDirCorners', 'Torus']
+
+parser = optparse.OptionParser(
+    usage='%prog [options] <gem5 binary> [-- <config options>]')
+
+parser.add_option('-s', '--sizes', default='16,64,256',
+                  help='comma separated numbers of CPUs (and routers)')
+parser.add_option('-t', '--topologies', default=','.join(topologies),
+                  help='comma separated topologies to time')
+parser.add_option('-r', '--repeat', type='int', default=1,
+                  help='runs of each configuration, the fastest is kept')
+parser.add_option('-d', '--directory', default='topology-startup',
+                  help='output directory of the runs')
+
+(options, args) = parser.parse_args()
+
+if len(args) < 1:
+    parser.print_help()
+    sys.exit(1)
+
+m5_binary = args[0]
+config_options = args[1:]
+config = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                      os.pardir, 'configs', 'example',
+                      'ruby_network_test.py')
+
+def mesh_rows(cpus):
+    # the most square mesh that the routers fill exactly
+    rows = int(math.sqrt(cpus))
+    while cpus % rows:
+        rows -= 1
+    return rows
+
+def run(topology, cpus):
+    outdir = os.path.join(options.directory, '%s.%d' % (topology, cpus))
+    cmd = [m5_binary, '-re', '-d', outdir, config,
+           '--topology=%s' % topology,
+           '--num-cpus=%d' % cpus,
+           '--mesh-rows=%d' % mesh_rows(cpus),
+           '--num-dirs=%d' % (4 if topology == 'MeshDirCorners' else cpus),
+           '--sim-cycles=1'] + config_options
+    best = None
+    for i in range(options.repeat):
+        start = time.time()
+        status = subprocess.call(cmd)
+        elapsed = time.time() - start
+        if status != 0:
+            return None
+        best = elapsed if best is None else min(best, elapsed)
+    return best
+
+sizes = [int(s) for s in options.sizes.split(',')]
+selected = options.topologies.split(',')
+
+print '%-16s' % 'topology',
+for cpus in sizes:
+    print '%10d' % cpus,
+print
+
+for topology in selected:
+    print '%-16s' % topology,
+    sys.stdout.flush()
+    for cpus in sizes:
+        seconds = run(topology, cpus)
+        if seconds is None:
+            print '%10s' % 'failed',
+        else:
+            print '%10.2f' % seconds,
+        sys.stdout.flush()
+    print